@@ -1,5 +1,7 @@
 #include "BonusController.hpp"
 #include <sstream>
+#include <algorithm>
+#include <unordered_map>
 
 // Health check endpoint
 crow::response BonusController::health_check() {
@@ -22,7 +24,34 @@ crow::response BonusController::health_check() {
     }
 }
 
+// Счетчики выполнений prepared statements
+crow::response BonusController::get_statement_stats() {
+    nlohmann::json response = nlohmann::json::object();
+
+    for (const auto& [name, executions] : bonus_repository.get_statement_stats()) {
+        response[name] = executions;
+    }
+
+    crow::response res(200, response.dump());
+    res.set_header("Content-Type", "application/json");
+    return res;
+}
+
+// GET /api/v1/privilege/stats - агрегаты программы лояльности (из памяти, без запросов к БД)
+crow::response BonusController::get_loyalty_stats() {
+    if (!stats) {
+        return create_error_response(404, "Loyalty stats are disabled");
+    }
+
+    crow::response res(200, stats->to_json().dump());
+    res.set_header("Content-Type", "application/json");
+    return res;
+}
+
 // GET /api/v1/privilege - получить информацию о бонусном счете
+// ?history=false      - только баланс и статус
+// ?limit=N&cursor=... - страница истории (по умолчанию последние 20 записей)
+// ?ticketUid=...      - только операции по билету
 crow::response BonusController::get_privilege_info(const crow::request& req) {
     try {
         std::string username = req.get_header_value("X-User-Name");
@@ -31,25 +60,89 @@ crow::response BonusController::get_privilege_info(const crow::request& req) {
             return create_error_response(400, "Username header is required");
         }
 
-        auto privilege_opt = bonus_repository.get_privilege_by_username(username);
+        const char* history_param = req.url_params.get("history");
+        bool with_history = !history_param || std::string(history_param) != "false";
+
+        BonusRepository::HistoryPageQuery query;
+        query.username = username;
+
+        if (const char* limit_param = req.url_params.get("limit")) {
+            try {
+                query.limit = std::clamp(std::stoi(limit_param), 1, 100);
+            }
+            catch (const std::logic_error&) {
+                // invalid_argument и out_of_range из stoi
+                return create_error_response(400, "Invalid limit");
+            }
+        }
+
+        if (const char* cursor_param = req.url_params.get("cursor")) {
+            query.cursor = cursor_param;
+        }
+
+        if (const char* ticket_param = req.url_params.get("ticketUid")) {
+            if (!BonusRepository::is_valid_uuid(ticket_param)) {
+                return create_error_response(400, "Invalid ticketUid");
+            }
+            query.ticket_uid = std::string(ticket_param);
+        }
 
         nlohmann::json response;
+        std::optional<Privilege> privilege_opt;
+
+        if (ledger) {
+            // Баланс и статус - из памяти; история - из БД
+            auto account = ledger->get(username).value_or(BonusLedger::Account{});
+            response = {
+                {"balance", account.balance},
+                {"status", account.status}
+            };
+
+            if (with_history) {
+                // БД отстает от журнала на интервал записи: возврат билета сразу
+                // после покупки ищет операцию покупки по ?ticketUid=
+                ledger->sync();
 
-        if (!privilege_opt) {
-            Privilege new_privilege = bonus_repository.create_privilege(username, 0);
-            response = new_privilege.to_api_json();
+                // Запись журнала не отмечается в ReplicaRouter - история с primary
+                query.username.clear();
+                privilege_opt = bonus_repository.get_privilege_by_username(username);
+            }
         }
         else {
-            Privilege privilege = privilege_opt.value();
+            privilege_opt = bonus_repository.get_privilege_by_username(username);
 
-            auto history = bonus_repository.get_privilege_history(privilege.id);
+            if (!privilege_opt) {
+                Privilege new_privilege = bonus_repository.create_privilege(username, 0);
+                response = new_privilege.to_api_json();
+            }
+            else {
+                response = privilege_opt->to_api_json();
+            }
+        }
+
+        if (with_history && privilege_opt) {
+            query.privilege_id = privilege_opt->id;
+            auto page = bonus_repository.get_privilege_history(query);
 
-            response = privilege.to_api_json();
             response["history"] = nlohmann::json::array();
 
-            for (const auto& history_item : history) {
+            for (const auto& history_item : page.history) {
                 response["history"].push_back(history_item.to_json());
             }
+
+            if (!page.next_cursor.empty()) {
+                response["nextCursor"] = page.next_cursor;
+            }
+            else if (!query.ticket_uid) {
+                // История кончилась - более старые операции только в итогах архива
+                if (auto snapshot = bonus_repository.get_balance_snapshot(privilege_opt->id)) {
+                    response["archived"] = {
+                        {"balance", snapshot->balance},
+                        {"operations", snapshot->operations},
+                        {"until", snapshot->archived_until}
+                    };
+                }
+            }
         }
 
         crow::response res(200, response.dump());
@@ -57,12 +150,272 @@ crow::response BonusController::get_privilege_info(const crow::request& req) {
         return res;
 
     }
+    catch (const std::invalid_argument& e) {
+        return create_error_response(400, e.what());
+    }
     catch (const std::exception& e) {
         std::cerr << "Error getting privilege info: " << e.what() << std::endl;
         return create_error_response(500, "Internal server error");
     }
 }
 
+// POST /api/v1/privilege/batch - балансы нескольких пользователей
+// {"usernames": [...]} -> {"items": [{"username", "balance", "status"}, ...]}
+// Пользователи без счета возвращаются с нулевым балансом.
+crow::response BonusController::get_privileges_batch(const crow::request& req) {
+    std::vector<std::string> usernames;
+
+    try {
+        auto json_body = nlohmann::json::parse(req.body);
+        usernames = json_body.at("usernames").get<std::vector<std::string>>();
+    }
+    catch (const std::exception& e) {
+        return create_error_response(400, "Invalid request body");
+    }
+
+    if (usernames.size() > 1000) {
+        return create_error_response(400, "Too many usernames");
+    }
+
+    try {
+        std::sort(usernames.begin(), usernames.end());
+        usernames.erase(std::unique(usernames.begin(), usernames.end()), usernames.end());
+
+        std::unordered_map<std::string, nlohmann::json> found;
+
+        if (ledger) {
+            for (const auto& username : usernames) {
+                if (auto account = ledger->get(username)) {
+                    found[username] = { {"balance", account->balance}, {"status", account->status} };
+                }
+            }
+        }
+        else {
+            for (const auto& privilege : bonus_repository.get_privileges_by_usernames(usernames)) {
+                found[privilege.username] = privilege.to_api_json();
+            }
+        }
+
+        nlohmann::json items = nlohmann::json::array();
+
+        for (const auto& username : usernames) {
+            auto it = found.find(username);
+
+            nlohmann::json item = it != found.end()
+                ? it->second
+                : nlohmann::json{ {"balance", 0}, {"status", "BRONZE"} };
+            item["username"] = username;
+
+            items.push_back(std::move(item));
+        }
+
+        nlohmann::json response = { {"items", items} };
+
+        crow::response res(200, response.dump());
+        res.set_header("Content-Type", "application/json");
+        return res;
+
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error getting privileges batch: " << e.what() << std::endl;
+        return create_error_response(500, "Internal server error");
+    }
+}
+
+// POST /api/v1/privilege/bulk - пачка начислений и списаний
+// {"entries": [{"username", "ticketUid", "balanceDiff", "operationType"}, ...]}
+// -> {"applied", "rejected", "results": [{"status", "balance"}, ...]} в порядке entries
+crow::response BonusController::bulk_update_balances(const crow::request& req) {
+    std::vector<BonusRepository::BulkEntry> entries;
+
+    try {
+        auto json_body = nlohmann::json::parse(req.body);
+
+        for (const auto& item : json_body.at("entries")) {
+            BonusRepository::BulkEntry entry;
+            entry.username = item.at("username").get<std::string>();
+            entry.ticket_uid = item.at("ticketUid").get<std::string>();
+            entry.balance_diff = item.at("balanceDiff").get<int>();
+            entry.operation_type = item.at("operationType").get<std::string>();
+            entries.push_back(std::move(entry));
+        }
+    }
+    catch (const std::exception& e) {
+        return create_error_response(400, "Invalid request body");
+    }
+
+    if (entries.size() > 10000) {
+        return create_error_response(400, "Too many entries");
+    }
+
+    try {
+        std::vector<BonusRepository::BulkResult> results;
+
+        if (ledger) {
+            // В памяти операции применяются по одной, без пакетной семантики
+            results.reserve(entries.size());
+
+            for (const auto& entry : entries) {
+                BonusRepository::BulkResult result;
+
+                try {
+                    auto account = ledger->apply(entry.username, entry.ticket_uid,
+                        entry.balance_diff, entry.operation_type);
+
+                    result.status = account
+                        ? BonusRepository::BulkStatus::Applied
+                        : BonusRepository::BulkStatus::InsufficientBalance;
+                    result.balance = account ? account->balance : 0;
+                }
+                catch (const std::invalid_argument&) {
+                    result.status = BonusRepository::BulkStatus::Invalid;
+                }
+
+                results.push_back(result);
+            }
+        }
+        else {
+            results = bonus_repository.bulk_update_balances(entries);
+        }
+
+        nlohmann::json items = nlohmann::json::array();
+        int applied = 0;
+
+        for (const auto& result : results) {
+            switch (result.status) {
+            case BonusRepository::BulkStatus::Applied:
+                items.push_back({ {"status", "APPLIED"}, {"balance", result.balance} });
+                ++applied;
+                break;
+            case BonusRepository::BulkStatus::InsufficientBalance:
+                items.push_back({ {"status", "INSUFFICIENT_BALANCE"} });
+                break;
+            case BonusRepository::BulkStatus::Invalid:
+                items.push_back({ {"status", "INVALID"} });
+                break;
+            }
+        }
+
+        nlohmann::json response = {
+            {"applied", applied},
+            {"rejected", static_cast<int>(results.size()) - applied},
+            {"results", items}
+        };
+
+        crow::response res(200, response.dump());
+        res.set_header("Content-Type", "application/json");
+        return res;
+
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error applying bulk update: " << e.what() << std::endl;
+        return create_error_response(500, "Internal server error");
+    }
+}
+
+// POST /api/v1/privilege/reverse - отмена бонусных операций по билетам
+// {"entries": [{"username", "ticketUid"}, ...]}
+// -> {"results": [{"status", "balanceDiff", "balance"}, ...]} в порядке entries.
+// Повторный вызов для тех же билетов ничего не меняет (ALREADY_REVERSED).
+crow::response BonusController::reverse_operations(const crow::request& req) {
+    std::vector<BonusRepository::ReverseEntry> entries;
+
+    try {
+        auto json_body = nlohmann::json::parse(req.body);
+
+        for (const auto& item : json_body.at("entries")) {
+            entries.push_back({
+                item.at("username").get<std::string>(),
+                item.at("ticketUid").get<std::string>()
+            });
+        }
+    }
+    catch (const std::exception& e) {
+        return create_error_response(400, "Invalid request body");
+    }
+
+    if (entries.size() > 10000) {
+        return create_error_response(400, "Too many entries");
+    }
+
+    try {
+        std::vector<BonusRepository::ReverseResult> results;
+
+        if (ledger) {
+            std::lock_guard<std::mutex> lock(reverse_mutex);
+
+            // История в БД должна включать все операции журнала
+            ledger->sync();
+
+            auto plan = bonus_repository.plan_reversals(entries);
+
+            for (std::size_t i = 0; i < plan.positions.size(); ++i) {
+                const auto& operation = plan.operations[i];
+                auto& result = plan.results[plan.positions[i]];
+
+                auto account = ledger->apply(operation.username, operation.ticket_uid,
+                    operation.balance_diff, operation.operation_type);
+
+                if (account) {
+                    result.status = BonusRepository::ReverseStatus::Reversed;
+                    result.balance = account->balance;
+                }
+                else {
+                    result.status = BonusRepository::ReverseStatus::InsufficientBalance;
+                }
+            }
+
+            ledger->sync();
+            results = std::move(plan.results);
+        }
+        else {
+            results = bonus_repository.reverse_operations(entries);
+        }
+
+        nlohmann::json items = nlohmann::json::array();
+        int reversed = 0;
+
+        for (const auto& result : results) {
+            nlohmann::json item;
+
+            switch (result.status) {
+            case BonusRepository::ReverseStatus::Reversed:
+                item = { {"status", "REVERSED"}, {"balanceDiff", result.balance_diff}, {"balance", result.balance} };
+                ++reversed;
+                break;
+            case BonusRepository::ReverseStatus::AlreadyReversed:
+                item = { {"status", "ALREADY_REVERSED"} };
+                break;
+            case BonusRepository::ReverseStatus::NotFound:
+                item = { {"status", "NOT_FOUND"} };
+                break;
+            case BonusRepository::ReverseStatus::InsufficientBalance:
+                item = { {"status", "INSUFFICIENT_BALANCE"}, {"balanceDiff", result.balance_diff} };
+                break;
+            case BonusRepository::ReverseStatus::Invalid:
+                item = { {"status", "INVALID"} };
+                break;
+            }
+
+            items.push_back(std::move(item));
+        }
+
+        nlohmann::json response = {
+            {"reversed", reversed},
+            {"results", items}
+        };
+
+        crow::response res(200, response.dump());
+        res.set_header("Content-Type", "application/json");
+        return res;
+
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error reversing operations: " << e.what() << std::endl;
+        return create_error_response(500, "Internal server error");
+    }
+}
+
 // Обновление баланса привилегий
 crow::response BonusController::update_privilege_balance(const crow::request& req,
     const std::string& username,
@@ -74,9 +427,9 @@ crow::response BonusController::update_privilege_balance(const crow::request& re
             return create_error_response(400, "Username is required");
         }
 
-        bool success = bonus_repository.update_privilege_balance(
-            username, ticket_uid, balance_diff, operation_type
-        );
+        bool success = ledger
+            ? ledger->apply(username, ticket_uid, balance_diff, operation_type).has_value()
+            : bonus_repository.update_privilege_balance(username, ticket_uid, balance_diff, operation_type);
 
         if (!success) {
             return create_error_response(500, "Failed to update privilege balance");
@@ -92,6 +445,9 @@ crow::response BonusController::update_privilege_balance(const crow::request& re
         return res;
 
     }
+    catch (const std::invalid_argument& e) {
+        return create_error_response(400, e.what());
+    }
     catch (const std::exception& e) {
         std::cerr << "Error updating privilege balance: " << e.what() << std::endl;
         return create_error_response(500, "Internal server error");
@@ -118,6 +474,12 @@ void BonusController::router(crow::SimpleApp& app) {
         return this->health_check();
             });
 
+    CROW_ROUTE(app, "/manage/statements")
+        .methods("GET"_method)
+        ([this]() {
+        return this->get_statement_stats();
+            });
+
     // GET /api/v1/privilege - информация о бонусном счете
     CROW_ROUTE(app, "/api/v1/privilege")
         .methods("GET"_method)
@@ -125,6 +487,34 @@ void BonusController::router(crow::SimpleApp& app) {
         return this->get_privilege_info(req);
             });
 
+    // GET /api/v1/privilege/stats - агрегаты программы лояльности
+    CROW_ROUTE(app, "/api/v1/privilege/stats")
+        .methods("GET"_method)
+        ([this]() {
+        return this->get_loyalty_stats();
+            });
+
+    // POST /api/v1/privilege/batch - балансы нескольких пользователей (внутренний endpoint)
+    CROW_ROUTE(app, "/api/v1/privilege/batch")
+        .methods("POST"_method)
+        ([this](const crow::request& req) {
+        return this->get_privileges_batch(req);
+            });
+
+    // POST /api/v1/privilege/bulk - пачка изменений баланса (внутренний endpoint)
+    CROW_ROUTE(app, "/api/v1/privilege/bulk")
+        .methods("POST"_method)
+        ([this](const crow::request& req) {
+        return this->bulk_update_balances(req);
+            });
+
+    // POST /api/v1/privilege/reverse - отмена операций по билетам (внутренний endpoint)
+    CROW_ROUTE(app, "/api/v1/privilege/reverse")
+        .methods("POST"_method)
+        ([this](const crow::request& req) {
+        return this->reverse_operations(req);
+            });
+
     // POST /api/v1/privilege/update - обновление баланса (внутренний endpoint)
     CROW_ROUTE(app, "/api/v1/privilege/update")
         .methods("POST"_method)
@@ -1,21 +1,43 @@
 #pragma once
 #include <crow.h>
 #include <nlohmann/json.hpp>
+#include <mutex>
 #include "../database/BonusRepository.hpp"
+#include "../ledger/BonusLedger.hpp"
+#include "../stats/LoyaltyStats.hpp"
 
 class BonusController {
 private:
     BonusRepository& bonus_repository;
 
+    // Балансы в памяти; nullptr - все операции через БД
+    BonusLedger* ledger;
+
+    // Агрегаты лояльности; nullptr - endpoint статистики недоступен
+    LoyaltyStats* stats;
+
+    // В режиме журнала отмены выполняются по одной (история читается из БД)
+    std::mutex reverse_mutex;
+
 public:
-    explicit BonusController(BonusRepository& repo) : bonus_repository(repo) {}
+    explicit BonusController(BonusRepository& repo, BonusLedger* ledger = nullptr,
+        LoyaltyStats* stats = nullptr)
+        : bonus_repository(repo)
+        , ledger(ledger)
+        , stats(stats) {
+    }
 
     void router(crow::SimpleApp& app);
 
 private:
     crow::response health_check();
+    crow::response get_statement_stats();
 
     crow::response get_privilege_info(const crow::request& req);
+    crow::response get_privileges_batch(const crow::request& req);
+    crow::response get_loyalty_stats();
+    crow::response bulk_update_balances(const crow::request& req);
+    crow::response reverse_operations(const crow::request& req);
 
     crow::response update_privilege_balance(const crow::request& req,
         const std::string& username,
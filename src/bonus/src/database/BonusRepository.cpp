@@ -4,78 +4,204 @@
 #include <iomanip>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
+#include <cctype>
+#include <unordered_map>
+
+BonusRepository::BonusRepository(const std::string& connection_string, std::size_t pool_size,
+    const ReplicaRouter::Options& replica_options, LoyaltyStats* stats)
+    : stats(stats) {
+    // Схема создается миграциями (см. Migrations) до создания репозитория
+    register_statements();
 
-BonusRepository::BonusRepository(const std::string& connection_string) {
     try {
-        connection = std::make_unique<pqxx::connection>(connection_string);
+        pool = std::make_unique<ConnectionPool>(connection_string, pool_size,
+            [this](pqxx::connection& conn) { statements.prepare(conn); });
         std::cout << "Bonus Service: Connected to database successfully" << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "Bonus Service: Database connection failed: " << e.what() << std::endl;
         throw;
     }
 
-    try {
-        pqxx::work txn(*connection);
-
-        std::string sql = "";
-
-        auto result = txn.exec("SELECT count(*) FROM information_schema.tables WHERE table_schema = 'public'");
-        sql.clear();
-
-        if (result[0][0].as<int>() == 0) {
-            sql.clear();
-            sql = "CREATE TABLE privilege\
-                (\
-                    id       SERIAL PRIMARY KEY,\
-                    username VARCHAR(80) NOT NULL UNIQUE,\
-                    status   VARCHAR(80) NOT NULL DEFAULT 'BRONZE'\
-                    CHECK(status IN('BRONZE', 'SILVER', 'GOLD')),\
-                    balance  INT\
-                    );";
-            result = txn.exec(sql);
-
-            sql.clear();
-            sql = "CREATE TABLE privilege_history\
-                (\
-                    id             SERIAL PRIMARY KEY,\
-                    privilege_id   INT REFERENCES privilege(id),\
-                    ticket_uid     uuid        NOT NULL,\
-                    datetime       TIMESTAMP   NOT NULL,\
-                    balance_diff   INT         NOT NULL,\
-                    operation_type VARCHAR(20) NOT NULL\
-                    CHECK(operation_type IN('FILL_IN_BALANCE', 'DEBIT_THE_ACCOUNT'))\
-                    );";
-            result = txn.exec(sql);
-            
-            sql.clear();
-            sql = "INSERT INTO privilege (username, status, balance) VALUES ('Test Max', 'GOLD', 1500);";
-            result = txn.exec(sql);
-
-            sql.clear();
-            sql = "INSERT INTO privilege_history (privilege_id, ticket_uid, datetime, balance_diff, operation_type)\
-                VALUES ('1', '049161bb-badd-4fa8-9d90-87c9a82b0668', '2021-10-08T19:59:19Z', '1500', 'FILL_IN_BALANCE');";
-            result = txn.exec(sql);
-        }
-        txn.commit();
+    if (!replica_options.connection_strings.empty()) {
+        replicas = std::make_unique<ReplicaRouter>(replica_options,
+            [this](pqxx::connection& conn) { statements.prepare(conn); });
+        replicas->start();
+        std::cout << "Bonus Service: Read replicas: " << replica_options.connection_strings.size() << std::endl;
     }
-    catch (const std::exception& e) {
-        std::cerr << "Create table database and dataset error: " << e.what() << std::endl;
-    }
-
 }
 
 BonusRepository::~BonusRepository() {
-    if (connection && connection->is_open()) {
-        connection->close();
+    if (replicas) {
+        replicas->stop();
     }
 }
 
+void BonusRepository::register_statements() {
+    statements.add("get_privilege_by_username", R"(
+            SELECT id, username, balance, status
+            FROM privilege
+            WHERE username = $1
+        )");
+
+    statements.add("get_privileges_by_usernames", R"(
+            SELECT id, username, balance, status
+            FROM privilege
+            WHERE username = ANY($1::varchar[])
+        )");
+
+    statements.add("create_privilege", R"(
+            INSERT INTO privilege (username, balance, status)
+            VALUES ($1, $2, $3)
+            RETURNING id, username, balance, status
+        )");
+
+    statements.add("ensure_privilege", R"(
+            INSERT INTO privilege (username, balance, status)
+            VALUES ($1, 0, 'BRONZE')
+            ON CONFLICT (username) DO NOTHING
+            RETURNING id
+        )");
+
+    // Баланс меняется только если не уходит в минус; статус по новому балансу
+    // (пороги как в get_privilege_status). История пишется в том же запросе.
+    // Строка блокируется в CTE current - прежние баланс и статус для агрегатов
+    // читаются из той же версии строки, которую меняет UPDATE.
+    statements.add("apply_balance_change", R"(
+            WITH current AS (
+                SELECT id, COALESCE(balance, 0) AS balance, status
+                FROM privilege
+                WHERE username = $1
+                FOR UPDATE
+            ), updated AS (
+                UPDATE privilege p
+                SET balance = c.balance + $2::int,
+                    status = CASE
+                        WHEN c.balance + $2::int >= 10000 THEN 'GOLD'
+                        WHEN c.balance + $2::int >= 5000 THEN 'SILVER'
+                        ELSE 'BRONZE'
+                    END
+                FROM current c
+                WHERE p.id = c.id AND c.balance + $2::int >= 0
+                RETURNING p.id, p.balance, p.status, c.balance AS old_balance, c.status AS old_status
+            ), history AS (
+                INSERT INTO privilege_history (privilege_id, ticket_uid, datetime, balance_diff, operation_type)
+                SELECT id, $3::uuid, CURRENT_TIMESTAMP, $2::int, $4::varchar
+                FROM updated
+            )
+            SELECT id, balance, status, old_balance, old_status FROM updated
+        )");
+
+    statements.add("get_all_balances",
+        "SELECT username, COALESCE(balance, 0) AS balance, status FROM privilege");
+
+    statements.add("get_tier_totals", R"(
+            SELECT status, COUNT(*) AS accounts, COALESCE(SUM(balance), 0) AS balance
+            FROM privilege
+            GROUP BY status
+        )");
+
+    statements.add("get_ledger_checkpoint",
+        "SELECT last_seq FROM ledger_checkpoint WHERE id = 1");
+
+    statements.add("ledger_ensure_privileges", R"(
+            INSERT INTO privilege (username, balance, status)
+            SELECT DISTINCT username, 0, 'BRONZE'
+            FROM unnest($1::varchar[]) AS username
+            ON CONFLICT (username) DO NOTHING
+        )");
+
+    statements.add("ledger_add_history", R"(
+            INSERT INTO privilege_history (privilege_id, ticket_uid, datetime, balance_diff, operation_type)
+            SELECT p.id, e.ticket_uid::uuid, to_timestamp(e.ts / 1000.0), e.balance_diff, e.operation_type
+            FROM unnest($1::varchar[], $2::varchar[], $3::bigint[], $4::int[], $5::varchar[])
+                AS e(username, ticket_uid, ts, balance_diff, operation_type)
+            JOIN privilege p ON p.username = e.username
+        )");
+
+    // Абсолютные значения - повторное применение безопасно
+    statements.add("ledger_set_balances", R"(
+            UPDATE privilege p
+            SET balance = v.balance, status = v.status
+            FROM unnest($1::varchar[], $2::int[], $3::varchar[]) AS v(username, balance, status)
+            WHERE p.username = v.username
+        )");
+
+    statements.add("ledger_set_checkpoint",
+        "UPDATE ledger_checkpoint SET last_seq = $1, updated_at = CURRENT_TIMESTAMP WHERE id = 1");
+
+    statements.add("lock_privileges_by_usernames", R"(
+            SELECT id FROM privilege
+            WHERE username = ANY($1::varchar[])
+            ORDER BY id
+            FOR UPDATE
+        )");
+
+    // Первая операция по билету и число операций по нему (больше одной - уже отменена).
+    // Операции по билету ищутся и в архиве истории
+    statements.add("get_ticket_operations", R"(
+            SELECT r.idx, h.balance_diff, h.operations
+            FROM unnest($1::varchar[], $2::uuid[]) WITH ORDINALITY AS r(username, ticket_uid, idx)
+            JOIN privilege p ON p.username = r.username
+            JOIN LATERAL (
+                SELECT (array_agg(t.balance_diff ORDER BY t.datetime, t.id))[1] AS balance_diff,
+                       COUNT(*) AS operations
+                FROM (
+                    SELECT id, datetime, balance_diff FROM privilege_history
+                    WHERE privilege_id = p.id AND ticket_uid = r.ticket_uid
+                    UNION ALL
+                    SELECT id, datetime, balance_diff FROM privilege_history_archive
+                    WHERE privilege_id = p.id AND ticket_uid = r.ticket_uid
+                ) t
+            ) h ON h.operations > 0
+        )");
+
+    statements.add("get_balance_snapshot", R"(
+            SELECT balance, operations, archived_until
+            FROM privilege_balance_snapshot
+            WHERE privilege_id = $1
+        )");
+
+    statements.add("get_privilege_history", R"(
+            SELECT id, privilege_id, ticket_uid, datetime, balance_diff, operation_type
+            FROM privilege_history
+            WHERE privilege_id = $1
+            ORDER BY datetime DESC, id DESC
+            LIMIT $2
+        )");
+
+    statements.add("get_privilege_history_after_cursor", R"(
+            SELECT id, privilege_id, ticket_uid, datetime, balance_diff, operation_type
+            FROM privilege_history
+            WHERE privilege_id = $1
+              AND (datetime, id) < ($2::timestamp, $3::int)
+            ORDER BY datetime DESC, id DESC
+            LIMIT $4
+        )");
+
+    statements.add("get_privilege_history_by_ticket", R"(
+            SELECT id, privilege_id, ticket_uid, datetime, balance_diff, operation_type
+            FROM privilege_history
+            WHERE ticket_uid = $2::uuid AND privilege_id = $1
+            UNION ALL
+            SELECT id, privilege_id, ticket_uid, datetime, balance_diff, operation_type
+            FROM privilege_history_archive
+            WHERE ticket_uid = $2::uuid AND privilege_id = $1
+            ORDER BY datetime DESC, id DESC
+            LIMIT $3
+        )");
+}
+
 bool BonusRepository::connect() {
-    return connection && connection->is_open();
+    return pool && pool->is_connected();
 }
 
 bool BonusRepository::is_connected() const {
-    return connection && connection->is_open();
+    return pool && pool->is_connected();
+}
+
+std::vector<std::pair<std::string, std::uint64_t>> BonusRepository::get_statement_stats() const {
+    return statements.get_execution_counts();
 }
 
 std::string BonusRepository::get_privilege_status(int balance) {
@@ -122,15 +248,10 @@ std::optional<Privilege> BonusRepository::get_privilege_by_username(const std::s
             throw std::runtime_error("Database not connected");
         }
 
+        auto connection = pool->acquire();
         pqxx::work txn(*connection);
 
-        std::string sql = R"(
-            SELECT id, username, balance, status
-            FROM privilege
-            WHERE username = $1
-        )";
-
-        auto result = txn.exec(sql, pqxx::params{ username });
+        auto result = statements.exec(txn, "get_privilege_by_username", pqxx::params{ username });
         txn.commit();
 
         if (result.empty()) {
@@ -146,6 +267,37 @@ std::optional<Privilege> BonusRepository::get_privilege_by_username(const std::s
     }
 }
 
+std::vector<Privilege> BonusRepository::get_privileges_by_usernames(const std::vector<std::string>& usernames) {
+    std::vector<Privilege> privileges;
+
+    if (usernames.empty()) {
+        return privileges;
+    }
+
+    try {
+        if (!is_connected()) {
+            throw std::runtime_error("Database not connected");
+        }
+
+        auto connection = pool->acquire();
+        pqxx::read_transaction txn(*connection);
+
+        auto result = statements.exec(txn, "get_privileges_by_usernames", pqxx::params{ usernames });
+        privileges.reserve(result.size());
+
+        for (const auto& row : result) {
+            privileges.push_back(create_privilege_from_row(row));
+        }
+
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error getting privileges: " << e.what() << std::endl;
+        throw;
+    }
+
+    return privileges;
+}
+
 Privilege BonusRepository::create_privilege(const std::string& username, int initial_balance) {
     try {
         if (!is_connected()) {
@@ -154,15 +306,10 @@ Privilege BonusRepository::create_privilege(const std::string& username, int ini
 
         std::string status = get_privilege_status(initial_balance);
 
+        auto connection = pool->acquire();
         pqxx::work txn(*connection);
 
-        std::string sql = R"(
-            INSERT INTO privilege (username, balance, status)
-            VALUES ($1, $2, $3)
-            RETURNING id, username, balance, status
-        )";
-
-        auto result = txn.exec(sql,
+        auto result = statements.exec(txn, "create_privilege",
             pqxx::params{ username, initial_balance, status }
         );
 
@@ -173,6 +320,14 @@ Privilege BonusRepository::create_privilege(const std::string& username, int ini
         Privilege privilege = create_privilege_from_row(result[0]);
         txn.commit();
 
+        if (replicas) {
+            replicas->record_write(username);
+        }
+
+        if (stats) {
+            stats->add_account(privilege.status, privilege.balance);
+        }
+
         return privilege;
 
     }
@@ -182,150 +337,797 @@ Privilege BonusRepository::create_privilege(const std::string& username, int ini
     }
 }
 
-bool BonusRepository::update_privilege_balance(const std::string& username, int balance_diff) {
+std::string BonusRepository::encode_cursor(const std::string& datetime, int id) {
+    static const char digits[] = "0123456789abcdef";
+
+    std::string raw = datetime + "|" + std::to_string(id);
+    std::string cursor;
+    cursor.reserve(raw.size() * 2);
+
+    for (unsigned char c : raw) {
+        cursor.push_back(digits[c >> 4]);
+        cursor.push_back(digits[c & 0xF]);
+    }
+
+    return cursor;
+}
+
+std::pair<std::string, int> BonusRepository::decode_cursor(const std::string& cursor) {
+    auto hex_value = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    };
+
+    if (cursor.empty() || cursor.size() % 2 != 0) {
+        throw std::invalid_argument("Invalid cursor");
+    }
+
+    std::string raw;
+    raw.reserve(cursor.size() / 2);
+
+    for (std::size_t i = 0; i < cursor.size(); i += 2) {
+        int high = hex_value(cursor[i]);
+        int low = hex_value(cursor[i + 1]);
+
+        if (high < 0 || low < 0) {
+            throw std::invalid_argument("Invalid cursor");
+        }
+        raw.push_back(static_cast<char>(high * 16 + low));
+    }
+
+    auto separator = raw.rfind('|');
+    if (separator == std::string::npos || separator == 0) {
+        throw std::invalid_argument("Invalid cursor");
+    }
+
+    try {
+        std::size_t parsed = 0;
+        int id = std::stoi(raw.substr(separator + 1), &parsed);
+
+        if (parsed != raw.size() - separator - 1) {
+            throw std::invalid_argument("Invalid cursor");
+        }
+        return { raw.substr(0, separator), id };
+    }
+    catch (const std::logic_error&) {
+        throw std::invalid_argument("Invalid cursor");
+    }
+}
+
+BonusRepository::HistoryPage BonusRepository::get_privilege_history(const HistoryPageQuery& query) {
+    HistoryPage page;
+
+    try {
+        if (!is_connected()) {
+            throw std::runtime_error("Database not connected");
+        }
+
+        std::optional<std::pair<std::string, int>> after;
+        if (!query.cursor.empty()) {
+            after = decode_cursor(query.cursor);
+        }
+
+        // Одна лишняя строка - признак следующей страницы
+        int fetch = query.limit + 1;
+
+        auto fetch_page = [&](pqxx::connection& connection) {
+            pqxx::read_transaction txn(connection);
+
+            if (query.ticket_uid) {
+                return statements.exec(txn, "get_privilege_history_by_ticket",
+                    pqxx::params{ query.privilege_id, *query.ticket_uid, fetch });
+            }
+            if (after) {
+                return statements.exec(txn, "get_privilege_history_after_cursor",
+                    pqxx::params{ query.privilege_id, after->first, after->second, fetch });
+            }
+            return statements.exec(txn, "get_privilege_history",
+                pqxx::params{ query.privilege_id, fetch });
+        };
+
+        // Без username нельзя проверить read-your-writes - читаем с primary
+        auto result = query.username.empty() ? fetch_page(*pool->acquire()) : read(query.username, fetch_page);
+
+        std::size_t count = std::min(result.size(), static_cast<std::size_t>(query.limit));
+        page.history.reserve(count);
+
+        for (std::size_t i = 0; i < count; ++i) {
+            page.history.push_back(create_history_from_row(result[i]));
+        }
+
+        if (result.size() > count && !query.ticket_uid) {
+            const auto& last = result[count - 1];
+            page.next_cursor = encode_cursor(last["datetime"].as<std::string>(), last["id"].as<int>());
+        }
+
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error getting privilege history: " << e.what() << std::endl;
+        throw;
+    }
+
+    return page;
+}
+
+bool BonusRepository::update_privilege_balance(const std::string& username,
+    const std::string& ticket_uid,
+    int balance_diff,
+    const std::string& operation_type) {
     try {
         if (!is_connected()) {
             throw std::runtime_error("Database not connected");
         }
 
+        std::string valid_operation_type = operation_type;
+        if (operation_type == "FILLED_BY_MONEY") {
+            valid_operation_type = "FILL_IN_BALANCE";
+        }
+
+        auto connection = pool->acquire();
         pqxx::work txn(*connection);
 
-        // Получаем текущий баланс
-        std::string select_sql = "SELECT balance FROM privilege WHERE username = $1";
-        auto select_result = txn.exec(select_sql, pqxx::params{ username });
+        pqxx::params params{ username, balance_diff, ticket_uid, valid_operation_type };
 
-        if (select_result.empty()) {
-            return false;
+        auto result = statements.exec(txn, "apply_balance_change", params);
+        bool created = false;
+
+        // Счета нет (или не хватает баланса) - создаем счет и пробуем еще раз
+        if (result.empty()) {
+            created = !statements.exec(txn, "ensure_privilege", pqxx::params{ username }).empty();
+            result = statements.exec(txn, "apply_balance_change", params);
         }
 
-        int current_balance = select_result[0]["balance"].as<int>();
-        int new_balance = current_balance + balance_diff;
+        // Созданный счет сохраняем и при отказе, как раньше
+        txn.commit();
 
-        if (new_balance < 0) {
-            return false;
+        if (stats && created) {
+            stats->add_account("BRONZE", 0);
         }
 
-        std::string status = get_privilege_status(new_balance);
+        if (result.empty()) {
+            return false;
+        }
 
-        std::string update_sql = R"(
-            UPDATE privilege
-            SET balance = $1, status = $2
-            WHERE username = $3
-        )";
+        if (replicas) {
+            replicas->record_write(username);
+        }
 
-        txn.exec(update_sql,
-            pqxx::params{ new_balance, status, username }
-        );
+        if (stats) {
+            const auto& row = result[0];
+            stats->on_account_change(row["old_status"].as<std::string>(), row["old_balance"].as<int>(),
+                row["status"].as<std::string>(), row["balance"].as<int>());
+            stats->record_operations(std::max(balance_diff, 0), std::max(-balance_diff, 0), 1);
+        }
 
-        txn.commit();
         return true;
 
     }
     catch (const std::exception& e) {
-        std::cerr << "Error updating privilege balance: " << e.what() << std::endl;
+        std::cerr << "Error in combined update: " << e.what() << std::endl;
         throw;
     }
 }
 
-std::vector<PrivilegeHistory> BonusRepository::get_privilege_history(int privilege_id) {
-    std::vector<PrivilegeHistory> history;
+std::vector<BonusRepository::BalanceRow> BonusRepository::get_all_balances() {
+    std::vector<BalanceRow> balances;
 
     try {
         if (!is_connected()) {
             throw std::runtime_error("Database not connected");
         }
 
+        auto connection = pool->acquire();
+        pqxx::read_transaction txn(*connection);
+
+        auto result = statements.exec(txn, "get_all_balances");
+        balances.reserve(result.size());
+
+        for (const auto& row : result) {
+            balances.push_back({
+                row["username"].as<std::string>(),
+                row["balance"].as<int>(),
+                row["status"].as<std::string>()
+            });
+        }
+
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error loading balances: " << e.what() << std::endl;
+        throw;
+    }
+
+    return balances;
+}
+
+std::vector<BonusRepository::TierTotal> BonusRepository::get_tier_totals() {
+    std::vector<TierTotal> totals;
+
+    try {
+        if (!is_connected()) {
+            throw std::runtime_error("Database not connected");
+        }
+
+        auto connection = pool->acquire();
+        pqxx::read_transaction txn(*connection);
+
+        for (const auto& row : statements.exec(txn, "get_tier_totals")) {
+            totals.push_back({
+                row["status"].as<std::string>(),
+                row["accounts"].as<std::int64_t>(),
+                row["balance"].as<std::int64_t>()
+            });
+        }
+
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error loading tier totals: " << e.what() << std::endl;
+        throw;
+    }
+
+    return totals;
+}
+
+std::int64_t BonusRepository::get_ledger_checkpoint() {
+    try {
+        if (!is_connected()) {
+            throw std::runtime_error("Database not connected");
+        }
+
+        auto connection = pool->acquire();
+        pqxx::read_transaction txn(*connection);
+
+        auto result = statements.exec(txn, "get_ledger_checkpoint");
+        return result.empty() ? 0 : result[0]["last_seq"].as<std::int64_t>();
+
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error reading ledger checkpoint: " << e.what() << std::endl;
+        throw;
+    }
+}
+
+void BonusRepository::persist_ledger_entries(const std::vector<LedgerEntry>& entries) {
+    if (entries.empty()) {
+        return;
+    }
+
+    try {
+        if (!is_connected()) {
+            throw std::runtime_error("Database not connected");
+        }
+
+        std::vector<std::string> usernames;
+        std::vector<std::string> ticket_uids;
+        std::vector<std::int64_t> timestamps;
+        std::vector<int> diffs;
+        std::vector<std::string> operation_types;
+
+        usernames.reserve(entries.size());
+        ticket_uids.reserve(entries.size());
+        timestamps.reserve(entries.size());
+        diffs.reserve(entries.size());
+        operation_types.reserve(entries.size());
+
+        // Итоговый баланс пользователя - из его последней операции
+        std::unordered_map<std::string, const LedgerEntry*> last_by_user;
+        std::int64_t last_seq = 0;
+
+        for (const auto& entry : entries) {
+            usernames.push_back(entry.username);
+            ticket_uids.push_back(entry.ticket_uid);
+            timestamps.push_back(entry.timestamp_ms);
+            diffs.push_back(entry.balance_diff);
+            operation_types.push_back(entry.operation_type);
+
+            auto& last = last_by_user[entry.username];
+            if (!last || last->seq < entry.seq) {
+                last = &entry;
+            }
+            last_seq = std::max(last_seq, entry.seq);
+        }
+
+        std::vector<std::string> balance_users;
+        std::vector<int> balances;
+        std::vector<std::string> statuses;
+
+        for (const auto& [username, entry] : last_by_user) {
+            balance_users.push_back(username);
+            balances.push_back(entry->balance);
+            statuses.push_back(entry->status);
+        }
+
+        auto connection = pool->acquire();
         pqxx::work txn(*connection);
 
-        std::string sql = R"(
-            SELECT id, privilege_id, ticket_uid, datetime, balance_diff, operation_type
-            FROM privilege_history
-            WHERE privilege_id = $1
-            ORDER BY datetime DESC
-        )";
+        statements.exec(txn, "ledger_ensure_privileges", pqxx::params{ balance_users });
+        statements.exec(txn, "ledger_add_history",
+            pqxx::params{ usernames, ticket_uids, timestamps, diffs, operation_types });
+        statements.exec(txn, "ledger_set_balances", pqxx::params{ balance_users, balances, statuses });
+        statements.exec(txn, "ledger_set_checkpoint", pqxx::params{ last_seq });
 
-        auto result = txn.exec(sql, pqxx::params{ privilege_id });
         txn.commit();
 
-        for (const auto& row : result) {
-            history.push_back(create_history_from_row(row));
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error persisting ledger entries: " << e.what() << std::endl;
+        throw;
+    }
+}
+
+std::size_t BonusRepository::export_ticket_bonus_usage(std::ostream& out) {
+    std::size_t count = 0;
+
+    try {
+        if (!is_connected()) {
+            throw std::runtime_error("Database not connected");
+        }
+
+        // Выгрузка не привязана к пользователю - подходит любая реплика
+        ConnectionPool* source = replicas ? replicas->pool_for_read("") : nullptr;
+
+        auto connection = (source ? source : pool.get())->acquire();
+        pqxx::read_transaction txn(*connection);
+
+        // Сумма считается в БД - одна строка на билет, с учетом архива
+        std::string query =
+            "SELECT ticket_uid::text, SUM(balance_diff)::bigint "
+            "FROM (SELECT ticket_uid, balance_diff FROM privilege_history "
+            "UNION ALL SELECT ticket_uid, balance_diff FROM privilege_history_archive) h "
+            "GROUP BY ticket_uid "
+            "HAVING SUM(balance_diff) <> 0";
+
+        out << "ticketUid,balanceDiff\n";
+
+        for (auto [ticket_uid, balance_diff] : txn.stream<std::string_view, std::int64_t>(query)) {
+            out << ticket_uid << ',' << balance_diff << '\n';
+            ++count;
         }
 
+        txn.commit();
+
     }
     catch (const std::exception& e) {
-        std::cerr << "Error getting privilege history: " << e.what() << std::endl;
+        std::cerr << "Error exporting ticket bonus usage: " << e.what() << std::endl;
         throw;
     }
 
-    return history;
+    return count;
 }
 
-void BonusRepository::add_privilege_history(int privilege_id, const std::string& ticket_uid,
-    int balance_diff, const std::string& operation_type) {
+std::optional<BonusRepository::BalanceSnapshot> BonusRepository::get_balance_snapshot(int privilege_id) {
     try {
         if (!is_connected()) {
             throw std::runtime_error("Database not connected");
         }
 
+        auto connection = pool->acquire();
+        pqxx::read_transaction txn(*connection);
+
+        auto result = statements.exec(txn, "get_balance_snapshot", pqxx::params{ privilege_id });
+
+        if (result.empty()) {
+            return std::nullopt;
+        }
+
+        BalanceSnapshot snapshot;
+        snapshot.balance = result[0]["balance"].as<int>();
+        snapshot.operations = result[0]["operations"].as<std::int64_t>();
+        snapshot.archived_until = result[0]["archived_until"].as<std::string>();
+        return snapshot;
+
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error getting balance snapshot: " << e.what() << std::endl;
+        throw;
+    }
+}
+
+int BonusRepository::ensure_history_partitions(int months_ahead) {
+    try {
+        auto connection = pool->acquire();
         pqxx::work txn(*connection);
 
-        std::cout << "DEBUG: Adding history record" << std::endl;
+        auto result = txn.exec("SELECT ensure_privilege_history_partitions($1)", pqxx::params{ months_ahead });
+        txn.commit();
 
-        std::string sql = R"(
-            INSERT INTO privilege_history (privilege_id, ticket_uid, datetime, balance_diff, operation_type)
-            VALUES ($1, $2, CURRENT_TIMESTAMP, $3, $4)
-        )";
+        return result[0][0].as<int>();
 
-        txn.exec(sql,
-            pqxx::params{ privilege_id, ticket_uid, balance_diff, operation_type }
-        );
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error creating history partitions: " << e.what() << std::endl;
+        throw;
+    }
+}
 
+int BonusRepository::archive_history_partitions(int retention_months) {
+    try {
+        auto connection = pool->acquire();
+        pqxx::work txn(*connection);
+
+        // DETACH берет эксклюзивную блокировку - архивирует один экземпляр
+        auto locked = txn.exec("SELECT pg_try_advisory_xact_lock(7316202602)");
+        if (!locked[0][0].as<bool>()) {
+            return 0;
+        }
+
+        auto result = txn.exec("SELECT archive_privilege_history_partitions($1)", pqxx::params{ retention_months });
         txn.commit();
-        std::cout << "DEBUG: History record added successfully" << std::endl;
+
+        return result[0][0].as<int>();
 
     }
     catch (const std::exception& e) {
-        std::cerr << "Error adding privilege history: " << e.what() << std::endl;
+        std::cerr << "Error archiving history partitions: " << e.what() << std::endl;
         throw;
     }
 }
 
-bool BonusRepository::update_privilege_balance(const std::string& username,
-    const std::string& ticket_uid,
-    int balance_diff,
-    const std::string& operation_type) {
+bool BonusRepository::is_valid_uuid(const std::string& value) {
+    if (value.size() != 36) {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        bool dash = i == 8 || i == 13 || i == 18 || i == 23;
+        if (dash ? value[i] != '-' : !std::isxdigit(static_cast<unsigned char>(value[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<BonusRepository::BulkResult> BonusRepository::bulk_update_balances(const std::vector<BulkEntry>& entries) {
+    std::vector<BulkResult> results;
+
     try {
         if (!is_connected()) {
             throw std::runtime_error("Database not connected");
         }
 
-        std::string valid_operation_type = operation_type;
-        if (operation_type == "FILLED_BY_MONEY") {
-            valid_operation_type = "FILL_IN_BALANCE";
+        auto connection = pool->acquire();
+        pqxx::work txn(*connection);
+
+        BulkStatsDelta delta;
+        results = apply_bulk(txn, entries, stats ? &delta : nullptr);
+        txn.commit();
+
+        record_bulk_stats(delta);
+
+        if (replicas) {
+            for (std::size_t i = 0; i < entries.size(); ++i) {
+                if (results[i].status == BulkStatus::Applied) {
+                    replicas->record_write(entries[i].username);
+                }
+            }
         }
 
-        auto privilege_opt = get_privilege_by_username(username);
-        int privilege_id;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error applying bulk balance update: " << e.what() << std::endl;
+        throw;
+    }
+
+    return results;
+}
+
+void BonusRepository::record_bulk_stats(const BulkStatsDelta& delta) {
+    if (!stats) {
+        return;
+    }
+
+    for (std::int64_t i = 0; i < delta.created; ++i) {
+        stats->add_account("BRONZE", 0);
+    }
+
+    for (const auto& [old_status, old_balance, new_status, new_balance] : delta.accounts) {
+        stats->on_account_change(old_status, old_balance, new_status, new_balance);
+    }
 
-        if (!privilege_opt) {
-            Privilege new_privilege = create_privilege(username, 0);
-            privilege_id = new_privilege.id;
+    if (delta.operations > 0) {
+        stats->record_operations(delta.accrued, delta.debited, delta.operations);
+    }
+}
+
+std::vector<BonusRepository::BulkResult> BonusRepository::apply_bulk(pqxx::work& txn,
+    const std::vector<BulkEntry>& entries, BulkStatsDelta* delta) {
+    std::vector<BulkResult> results(entries.size());
+
+    if (entries.empty()) {
+        return results;
+    }
+
+    // Временные таблицы не существуют при подготовке соединения -
+    // запросы к ним выполняются без prepared statements
+    txn.exec(R"(
+        CREATE TEMP TABLE bulk_privilege_ops
+        (
+            idx            INT         NOT NULL,
+            username       VARCHAR(80) NOT NULL,
+            ticket_uid     uuid        NOT NULL,
+            balance_diff   INT         NOT NULL,
+            operation_type VARCHAR(20) NOT NULL
+        ) ON COMMIT DROP
+    )");
+
+    std::size_t copied = 0;
+
+    {
+        auto stream = pqxx::stream_to::table(txn, { "bulk_privilege_ops" },
+            { "idx", "username", "ticket_uid", "balance_diff", "operation_type" });
+
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            const auto& entry = entries[i];
+
+            std::string operation_type = entry.operation_type == "FILLED_BY_MONEY"
+                ? "FILL_IN_BALANCE" : entry.operation_type;
+
+            // Некорректная строка сорвала бы COPY всей пачки
+            if (entry.username.empty() || entry.username.size() > 80 ||
+                !is_valid_uuid(entry.ticket_uid) ||
+                (operation_type != "FILL_IN_BALANCE" && operation_type != "DEBIT_THE_ACCOUNT")) {
+                continue;
+            }
+
+            stream.write_values(static_cast<int>(i), entry.username, entry.ticket_uid,
+                entry.balance_diff, operation_type);
+            ++copied;
+        }
+
+        stream.complete();
+    }
+
+    if (copied == 0) {
+        txn.exec("DROP TABLE bulk_privilege_ops");
+        return results;
+    }
+
+    // Новые счета вставляются по порядку имени: параллельные пачки с общими
+    // новыми пользователями берут блокировки уникального индекса в одном порядке
+    auto created = txn.exec(R"(
+        INSERT INTO privilege (username, balance, status)
+        SELECT DISTINCT username, 0, 'BRONZE'
+        FROM bulk_privilege_ops
+        ORDER BY username
+        ON CONFLICT (username) DO NOTHING
+        RETURNING id
+    )");
+
+    // Блокировка счетов в едином порядке - параллельные пачки не взаимоблокируются
+    txn.exec(R"(
+        SELECT id FROM privilege
+        WHERE username IN (SELECT username FROM bulk_privilege_ops)
+        ORDER BY id
+        FOR UPDATE
+    )");
+
+    // Баланс после каждой операции - нарастающим итогом в порядке входа
+    txn.exec(R"(
+        CREATE TEMP TABLE bulk_privilege_plan ON COMMIT DROP AS
+        SELECT r.*, bool_and(r.balance_after >= 0) OVER (PARTITION BY r.privilege_id) AS accepted
+        FROM (
+            SELECT o.idx, o.ticket_uid, o.balance_diff, o.operation_type,
+                   p.id AS privilege_id,
+                   COALESCE(p.balance, 0) AS balance_before,
+                   p.status AS status_before,
+                   COALESCE(p.balance, 0)
+                       + SUM(o.balance_diff) OVER (PARTITION BY p.id ORDER BY o.idx) AS balance_after
+            FROM bulk_privilege_ops o
+            JOIN privilege p ON p.username = o.username
+        ) r
+    )");
+
+    txn.exec(R"(
+        UPDATE privilege p
+        SET balance = t.balance,
+            status = CASE
+                WHEN t.balance >= 10000 THEN 'GOLD'
+                WHEN t.balance >= 5000 THEN 'SILVER'
+                ELSE 'BRONZE'
+            END
+        FROM (
+            SELECT DISTINCT ON (privilege_id) privilege_id, balance_after AS balance
+            FROM bulk_privilege_plan
+            WHERE accepted
+            ORDER BY privilege_id, idx DESC
+        ) t
+        WHERE p.id = t.privilege_id
+    )");
+
+    txn.exec(R"(
+        INSERT INTO privilege_history (privilege_id, ticket_uid, datetime, balance_diff, operation_type)
+        SELECT privilege_id, ticket_uid, CURRENT_TIMESTAMP, balance_diff, operation_type
+        FROM bulk_privilege_plan
+        WHERE accepted
+        ORDER BY idx
+    )");
+
+    auto plan = txn.exec("SELECT idx, accepted, balance_after FROM bulk_privilege_plan");
+
+    for (const auto& row : plan) {
+        auto& result = results[row["idx"].as<std::size_t>()];
+
+        if (row["accepted"].as<bool>()) {
+            result.status = BulkStatus::Applied;
+            result.balance = row["balance_after"].as<int>();
         }
         else {
-            privilege_id = privilege_opt.value().id;
+            result.status = BulkStatus::InsufficientBalance;
         }
+    }
 
-        if (!update_privilege_balance(username, balance_diff)) {
-            return false;
+    if (delta) {
+        delta->created += static_cast<std::int64_t>(created.size());
+
+        auto totals = txn.exec(R"(
+            SELECT COALESCE(SUM(balance_diff) FILTER (WHERE balance_diff > 0), 0) AS accrued,
+                   COALESCE(-SUM(balance_diff) FILTER (WHERE balance_diff < 0), 0) AS debited,
+                   COUNT(*) AS operations
+            FROM bulk_privilege_plan
+            WHERE accepted
+        )");
+
+        delta->accrued += totals[0]["accrued"].as<std::int64_t>();
+        delta->debited += totals[0]["debited"].as<std::int64_t>();
+        delta->operations += totals[0]["operations"].as<std::int64_t>();
+
+        auto accounts = txn.exec(R"(
+            SELECT DISTINCT ON (privilege_id)
+                   status_before, balance_before, balance_after
+            FROM bulk_privilege_plan
+            WHERE accepted
+            ORDER BY privilege_id, idx DESC
+        )");
+
+        for (const auto& row : accounts) {
+            int balance_after = row["balance_after"].as<int>();
+            delta->accounts.emplace_back(row["status_before"].as<std::string>(), row["balance_before"].as<int>(),
+                get_privilege_status(balance_after), balance_after);
         }
+    }
 
-        add_privilege_history(privilege_id, ticket_uid, balance_diff, operation_type);
+    // Таблицы не переживают транзакцию, но в ней может быть следующий вызов
+    txn.exec("DROP TABLE bulk_privilege_plan, bulk_privilege_ops");
 
-        return true;
+    return results;
+}
+
+BonusRepository::ReversePlan BonusRepository::plan_reversals(pqxx::transaction_base& txn,
+    const std::vector<ReverseEntry>& entries) {
+    ReversePlan plan;
+    plan.results.resize(entries.size());
+
+    std::vector<std::string> usernames;
+    std::vector<std::string> ticket_uids;
+    std::vector<std::size_t> query_positions;
+    std::unordered_map<std::string, std::size_t> first_entry;
+
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        const auto& entry = entries[i];
+
+        if (entry.username.empty() || !is_valid_uuid(entry.ticket_uid)) {
+            continue;
+        }
+
+        // Повтор билета в одном запросе - одна отмена
+        if (!first_entry.emplace(entry.username + "|" + entry.ticket_uid, i).second) {
+            plan.results[i].status = ReverseStatus::AlreadyReversed;
+            continue;
+        }
+
+        plan.results[i].status = ReverseStatus::NotFound;
+        usernames.push_back(entry.username);
+        ticket_uids.push_back(entry.ticket_uid);
+        query_positions.push_back(i);
+    }
+
+    if (query_positions.empty()) {
+        return plan;
+    }
+
+    auto result = statements.exec(txn, "get_ticket_operations", pqxx::params{ usernames, ticket_uids });
+
+    for (const auto& row : result) {
+        std::size_t position = query_positions[row["idx"].as<std::size_t>() - 1];
+        int original_diff = row["balance_diff"].as<int>();
+
+        if (row["operations"].as<long long>() > 1) {
+            plan.results[position].status = ReverseStatus::AlreadyReversed;
+            continue;
+        }
+
+        if (original_diff == 0) {
+            continue;
+        }
+
+        BulkEntry operation;
+        operation.username = entries[position].username;
+        operation.ticket_uid = entries[position].ticket_uid;
+        operation.balance_diff = -original_diff;
+        operation.operation_type = operation.balance_diff > 0 ? "FILL_IN_BALANCE" : "DEBIT_THE_ACCOUNT";
+
+        plan.results[position].balance_diff = operation.balance_diff;
+        plan.positions.push_back(position);
+        plan.operations.push_back(std::move(operation));
+    }
+
+    return plan;
+}
+
+BonusRepository::ReversePlan BonusRepository::plan_reversals(const std::vector<ReverseEntry>& entries) {
+    try {
+        if (!is_connected()) {
+            throw std::runtime_error("Database not connected");
+        }
+
+        auto connection = pool->acquire();
+        pqxx::read_transaction txn(*connection);
+
+        return plan_reversals(txn, entries);
 
     }
     catch (const std::exception& e) {
-        std::cerr << "Error in combined update: " << e.what() << std::endl;
+        std::cerr << "Error planning reversals: " << e.what() << std::endl;
+        throw;
+    }
+}
+
+std::vector<BonusRepository::ReverseResult> BonusRepository::reverse_operations(const std::vector<ReverseEntry>& entries) {
+    ReversePlan plan;
+
+    try {
+        if (!is_connected()) {
+            throw std::runtime_error("Database not connected");
+        }
+
+        std::vector<std::string> usernames;
+        usernames.reserve(entries.size());
+
+        for (const auto& entry : entries) {
+            usernames.push_back(entry.username);
+        }
+
+        auto connection = pool->acquire();
+        pqxx::work txn(*connection);
+
+        // Счета блокируются до чтения истории - параллельный возврат того же
+        // билета увидит уже записанную отмену
+        statements.exec(txn, "lock_privileges_by_usernames", pqxx::params{ usernames });
+
+        plan = plan_reversals(txn, entries);
+
+        BulkStatsDelta delta;
+        auto applied = apply_bulk(txn, plan.operations, stats ? &delta : nullptr);
+
+        for (std::size_t i = 0; i < plan.positions.size(); ++i) {
+            auto& result = plan.results[plan.positions[i]];
+
+            if (applied[i].status == BulkStatus::Applied) {
+                result.status = ReverseStatus::Reversed;
+                result.balance = applied[i].balance;
+            }
+            else {
+                result.status = ReverseStatus::InsufficientBalance;
+            }
+        }
+
+        txn.commit();
+
+        record_bulk_stats(delta);
+
+        if (replicas) {
+            for (std::size_t position : plan.positions) {
+                if (plan.results[position].status == ReverseStatus::Reversed) {
+                    replicas->record_write(entries[position].username);
+                }
+            }
+        }
+
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error reversing operations: " << e.what() << std::endl;
         throw;
     }
-}
\ No newline at end of file
+
+    return plan.results;
+}
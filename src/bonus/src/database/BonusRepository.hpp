@@ -2,37 +2,221 @@
 #include <memory>
 #include <vector>
 #include <optional>
+#include <tuple>
+#include <cstdint>
+#include <iostream>
+#include <ostream>
 #include <pqxx/pqxx>
+#include "ConnectionPool.hpp"
+#include "ReplicaRouter.hpp"
+#include "StatementRegistry.hpp"
 #include "../models/Privilege.hpp"
 #include "../models/PrivilegeHistory.hpp"
+#include "../models/LedgerEntry.hpp"
+#include "../stats/LoyaltyStats.hpp"
 
 class BonusRepository {
 private:
-    std::unique_ptr<pqxx::connection> connection;
+    StatementRegistry statements;
+    std::unique_ptr<ConnectionPool> pool;
+
+    // Реплики для чтения; nullptr - все запросы на primary
+    std::unique_ptr<ReplicaRouter> replicas;
+
+    // Агрегаты лояльности, обновляемые после commit; nullptr - не ведутся
+    LoyaltyStats* stats;
 
 public:
-    BonusRepository(const std::string& connection_string);
+    BonusRepository(const std::string& connection_string, std::size_t pool_size = 8,
+        const ReplicaRouter::Options& replica_options = {},
+        LoyaltyStats* stats = nullptr);
     ~BonusRepository();
 
     bool connect();
     bool is_connected() const;
 
+    // Количество выполнений каждого prepared statement
+    std::vector<std::pair<std::string, std::uint64_t>> get_statement_stats() const;
+
     std::optional<Privilege> get_privilege_by_username(const std::string& username);
+    // Счета нескольких пользователей одним запросом; отсутствующих в результате нет
+    std::vector<Privilege> get_privileges_by_usernames(const std::vector<std::string>& usernames);
     Privilege create_privilege(const std::string& username, int initial_balance = 0);
-    bool update_privilege_balance(const std::string& username, int balance_diff);
 
-    std::vector<PrivilegeHistory> get_privilege_history(int privilege_id);
-    void add_privilege_history(int privilege_id, const std::string& ticket_uid,
-        int balance_diff, const std::string& operation_type);
+    struct HistoryPageQuery {
+        int privilege_id = 0;
+        // Владелец счета (для read-your-writes); пусто - чтение с primary
+        std::string username;
+        int limit = 20;
+        // Непрозрачный курсор из предыдущей страницы
+        std::string cursor;
+        // Только операции по одному билету
+        std::optional<std::string> ticket_uid;
+    };
+
+    struct HistoryPage {
+        std::vector<PrivilegeHistory> history;
+        // Пусто - записей больше нет
+        std::string next_cursor;
+    };
+
+    // Последние записи истории в порядке (datetime DESC, id DESC).
+    // Бросает std::invalid_argument на некорректный курсор.
+    HistoryPage get_privilege_history(const HistoryPageQuery& query);
 
+    // Изменение баланса и запись в историю одной транзакцией.
+    // Счет создается, если его нет. false - баланс ушел бы в минус.
     bool update_privilege_balance(const std::string& username,
         const std::string& ticket_uid,
         int balance_diff,
         const std::string& operation_type);
 
+    struct BulkEntry {
+        std::string username;
+        std::string ticket_uid;
+        int balance_diff = 0;
+        std::string operation_type;
+    };
+
+    enum class BulkStatus { Applied, InsufficientBalance, Invalid };
+
+    struct BulkResult {
+        BulkStatus status = BulkStatus::Invalid;
+        // Баланс после операции (для Applied)
+        int balance = 0;
+    };
+
+    // Пачка операций одной транзакцией: COPY во временную таблицу, один UPDATE
+    // балансов и один INSERT истории. Операции пользователя применяются по
+    // порядку и все вместе: если баланс уходит в минус хотя бы после одной,
+    // отклоняются все операции этого пользователя. Результат - в порядке входа.
+    std::vector<BulkResult> bulk_update_balances(const std::vector<BulkEntry>& entries);
+
+    struct ReverseEntry {
+        std::string username;
+        std::string ticket_uid;
+    };
+
+    enum class ReverseStatus { Reversed, AlreadyReversed, NotFound, InsufficientBalance, Invalid };
+
+    struct ReverseResult {
+        ReverseStatus status = ReverseStatus::Invalid;
+        // Изменение баланса при отмене операции и баланс после него (для Reversed)
+        int balance_diff = 0;
+        int balance = 0;
+    };
+
+    // Отмена бонусных операций по билетам. Операция по билету отменяется
+    // один раз: если по билету в истории уже есть отмена, повтор ничего не меняет.
+    std::vector<ReverseResult> reverse_operations(const std::vector<ReverseEntry>& entries);
+
+    struct ReversePlan {
+        // Для отменяемых операций статус уточняется при применении
+        std::vector<ReverseResult> results;
+        // Позиции во входе и операции отмены для них
+        std::vector<std::size_t> positions;
+        std::vector<BulkEntry> operations;
+    };
+
+    // Отменяющие операции без применения (для режима журнала)
+    ReversePlan plan_reversals(const std::vector<ReverseEntry>& entries);
+
+    struct BalanceRow {
+        std::string username;
+        int balance;
+        std::string status;
+    };
+
+    // Балансы всех счетов (загрузка бонусного журнала)
+    std::vector<BalanceRow> get_all_balances();
+
+    struct TierTotal {
+        std::string status;
+        std::int64_t accounts = 0;
+        std::int64_t balance = 0;
+    };
+
+    // Число счетов и сумма балансов по статусам (начальные значения LoyaltyStats)
+    std::vector<TierTotal> get_tier_totals();
+
+    // Номер последней операции журнала, сохраненной в БД
+    std::int64_t get_ledger_checkpoint();
+
+    // Операции журнала одной транзакцией: счета, история, итоговые балансы
+    // и checkpoint. Повторная запись тех же операций не меняет балансы.
+    void persist_ledger_entries(const std::vector<LedgerEntry>& entries);
+
+    static std::string get_privilege_status(int balance);
+
+    // UUID в каноническом виде (8-4-4-4-12, шестнадцатеричные цифры)
+    static bool is_valid_uuid(const std::string& value);
+
+    // Чистая сумма бонусных операций по каждому билету, строки CSV
+    // "ticketUid,balanceDiff" (для отчета по рейсам Ticket Service).
+    // Билеты с нулевой суммой не выгружаются; возвращает число строк.
+    std::size_t export_ticket_bonus_usage(std::ostream& out);
+
+    struct BalanceSnapshot {
+        // Сумма операций, ушедших в архив, и их количество
+        int balance = 0;
+        std::int64_t operations = 0;
+        std::string archived_until;
+    };
+
+    // Итоги архивной истории счета; nullopt - архива нет
+    std::optional<BalanceSnapshot> get_balance_snapshot(int privilege_id);
+
+    // Партиции истории на текущий и months_ahead следующих месяцев; возвращает число созданных
+    int ensure_history_partitions(int months_ahead);
+
+    // Архивирует партиции старше retention_months месяцев; возвращает их число.
+    // Если архивирование уже идет в другом экземпляре, возвращает 0.
+    int archive_history_partitions(int retention_months);
+
 private:
+    void register_statements();
+
+    // Изменения агрегатов пачки; учитываются в stats после commit
+    struct BulkStatsDelta {
+        std::int64_t created = 0;
+        std::int64_t accrued = 0;
+        std::int64_t debited = 0;
+        std::int64_t operations = 0;
+        // Статус и баланс счета до и после пачки
+        std::vector<std::tuple<std::string, int, std::string, int>> accounts;
+    };
+
+    std::vector<BulkResult> apply_bulk(pqxx::work& txn, const std::vector<BulkEntry>& entries,
+        BulkStatsDelta* delta = nullptr);
+    void record_bulk_stats(const BulkStatsDelta& delta);
+    ReversePlan plan_reversals(pqxx::transaction_base& txn, const std::vector<ReverseEntry>& entries);
+
     Privilege create_privilege_from_row(const pqxx::row& row);
     PrivilegeHistory create_history_from_row(const pqxx::row& row);
 
-    std::string get_privilege_status(int balance);
+    // Чтение на реплике (если есть подходящая), иначе на primary.
+    // При обрыве соединения с репликой запрос повторяется на primary.
+    template <typename Fn>
+    auto read(const std::string& username, Fn&& fn) {
+        if (replicas) {
+            if (ConnectionPool* replica_pool = replicas->pool_for_read(username)) {
+                try {
+                    auto connection = replica_pool->acquire();
+                    return fn(*connection);
+                }
+                catch (const pqxx::broken_connection& e) {
+                    std::cerr << "Replica read failed, retrying on primary: " << e.what() << std::endl;
+                    replicas->report_failure(replica_pool);
+                }
+            }
+        }
+
+        auto connection = pool->acquire();
+        return fn(*connection);
+    }
+
+
+    // Курсор - hex от "datetime|id" последней записи страницы
+    static std::string encode_cursor(const std::string& datetime, int id);
+    static std::pair<std::string, int> decode_cursor(const std::string& cursor);
 };
\ No newline at end of file
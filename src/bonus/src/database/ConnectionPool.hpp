@@ -0,0 +1,55 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <pqxx/pqxx>
+
+// Пул соединений с БД. Каждое новое соединение проходит через initializer
+// (регистрация prepared statements), поэтому запросы по имени доступны
+// на любом соединении, выданном пулом.
+class ConnectionPool {
+public:
+    using Initializer = std::function<void(pqxx::connection&)>;
+
+    // RAII-аренда соединения: при разрушении возвращает его в пул
+    class Lease {
+    public:
+        Lease(ConnectionPool& pool, std::unique_ptr<pqxx::connection> connection);
+        Lease(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease& operator=(Lease&&) = delete;
+        ~Lease();
+
+        pqxx::connection& operator*() const { return *connection; }
+        pqxx::connection* operator->() const { return connection.get(); }
+
+    private:
+        ConnectionPool* pool;
+        std::unique_ptr<pqxx::connection> connection;
+    };
+
+    ConnectionPool(const std::string& connection_string, std::size_t capacity,
+        Initializer initializer = {});
+
+    Lease acquire();
+
+    bool is_connected() const;
+    std::size_t get_capacity() const { return capacity; }
+
+private:
+    std::unique_ptr<pqxx::connection> open_connection();
+    void release(std::unique_ptr<pqxx::connection> connection);
+
+    std::string connection_string;
+    std::size_t capacity;
+    Initializer initializer;
+
+    mutable std::mutex mutex;
+    std::condition_variable available;
+    std::vector<std::unique_ptr<pqxx::connection>> idle;
+    std::size_t open_count = 0;
+};
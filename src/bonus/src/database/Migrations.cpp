@@ -0,0 +1,275 @@
+#include "Migrations.hpp"
+
+std::vector<Migration> bonus_migrations() {
+    return {
+        { 1, "create privilege and privilege_history tables", {
+            R"(
+                CREATE TABLE IF NOT EXISTS privilege
+                (
+                    id       SERIAL PRIMARY KEY,
+                    username VARCHAR(80) NOT NULL UNIQUE,
+                    status   VARCHAR(80) NOT NULL DEFAULT 'BRONZE'
+                        CHECK (status IN ('BRONZE', 'SILVER', 'GOLD')),
+                    balance  INT
+                )
+            )",
+            R"(
+                CREATE TABLE IF NOT EXISTS privilege_history
+                (
+                    id             SERIAL PRIMARY KEY,
+                    privilege_id   INT REFERENCES privilege(id),
+                    ticket_uid     uuid        NOT NULL,
+                    datetime       TIMESTAMP   NOT NULL,
+                    balance_diff   INT         NOT NULL,
+                    operation_type VARCHAR(20) NOT NULL
+                        CHECK (operation_type IN ('FILL_IN_BALANCE', 'DEBIT_THE_ACCOUNT'))
+                )
+            )",
+            // Тестовые данные - только в пустую базу
+            R"(
+                INSERT INTO privilege (username, status, balance)
+                SELECT 'Test Max', 'GOLD', 1500
+                WHERE NOT EXISTS (SELECT 1 FROM privilege)
+            )",
+            R"(
+                INSERT INTO privilege_history (privilege_id, ticket_uid, datetime, balance_diff, operation_type)
+                SELECT id, '049161bb-badd-4fa8-9d90-87c9a82b0668', '2021-10-08T19:59:19Z', 1500, 'FILL_IN_BALANCE'
+                FROM privilege
+                WHERE username = 'Test Max'
+                  AND NOT EXISTS (SELECT 1 FROM privilege_history)
+            )"
+        } },
+        { 2, "add privilege history index", {
+            // get_privilege_history: WHERE privilege_id = $1 ORDER BY datetime DESC
+            "CREATE INDEX IF NOT EXISTS idx_privilege_history_privilege_id ON privilege_history (privilege_id, datetime DESC)"
+        } },
+        { 3, "keyset index for history pages and ticket_uid lookup", {
+            // Страницы истории: ORDER BY datetime DESC, id DESC с курсором (datetime, id)
+            "CREATE INDEX IF NOT EXISTS idx_privilege_history_page ON privilege_history (privilege_id, datetime DESC, id DESC)",
+            "DROP INDEX IF EXISTS idx_privilege_history_privilege_id",
+            // Поиск операции по билету при возврате
+            "CREATE INDEX IF NOT EXISTS idx_privilege_history_ticket_uid ON privilege_history (ticket_uid)"
+        } },
+        { 4, "create ledger checkpoint table", {
+            // Последняя операция бонусного журнала, записанная в БД
+            R"(
+                CREATE TABLE IF NOT EXISTS ledger_checkpoint
+                (
+                    id         INT PRIMARY KEY CHECK (id = 1),
+                    last_seq   BIGINT    NOT NULL DEFAULT 0,
+                    updated_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP
+                )
+            )",
+            "INSERT INTO ledger_checkpoint (id, last_seq) VALUES (1, 0) ON CONFLICT (id) DO NOTHING"
+        } },
+        { 5, "partition privilege_history by month", {
+            // Итоги истории, ушедшей в архив: баланс на archived_until и число операций
+            R"(
+                CREATE TABLE IF NOT EXISTS privilege_balance_snapshot
+                (
+                    privilege_id   INT PRIMARY KEY REFERENCES privilege(id),
+                    balance        INT       NOT NULL,
+                    operations     BIGINT    NOT NULL,
+                    archived_until TIMESTAMP NOT NULL,
+                    updated_at     TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP
+                )
+            )",
+            // Партиция privilege_history_YYYY_MM на месяц month_start
+            R"SQL(
+                CREATE OR REPLACE FUNCTION create_privilege_history_partition(month_start DATE) RETURNS VOID AS $fn$
+                BEGIN
+                    EXECUTE format('CREATE TABLE IF NOT EXISTS %I PARTITION OF privilege_history FOR VALUES FROM (%L) TO (%L)',
+                        'privilege_history_' || to_char(month_start, 'YYYY_MM'),
+                        month_start,
+                        (month_start + INTERVAL '1 month')::date);
+                END
+                $fn$ LANGUAGE plpgsql
+            )SQL",
+            // Партиции на текущий месяц и months_ahead следующих; возвращает число созданных
+            R"SQL(
+                CREATE OR REPLACE FUNCTION ensure_privilege_history_partitions(months_ahead INT) RETURNS INT AS $fn$
+                DECLARE
+                    month_start DATE := date_trunc('month', CURRENT_DATE)::date;
+                    created INT := 0;
+                BEGIN
+                    FOR i IN 0..months_ahead LOOP
+                        IF to_regclass('privilege_history_' || to_char(month_start, 'YYYY_MM')) IS NULL THEN
+                            PERFORM create_privilege_history_partition(month_start);
+                            created := created + 1;
+                        END IF;
+                        month_start := (month_start + INTERVAL '1 month')::date;
+                    END LOOP;
+                    RETURN created;
+                END
+                $fn$ LANGUAGE plpgsql
+            )SQL",
+            // Партиции старше retention_months месяцев: итоги по счетам добавляются
+            // в privilege_balance_snapshot, партиция отсоединяется и переименовывается
+            // в privilege_history_archive_YYYY_MM. Возвращает число партиций.
+            R"SQL(
+                CREATE OR REPLACE FUNCTION archive_privilege_history_partitions(retention_months INT) RETURNS INT AS $fn$
+                DECLARE
+                    cutoff DATE := (date_trunc('month', CURRENT_DATE) - make_interval(months => retention_months))::date;
+                    part RECORD;
+                    archived INT := 0;
+                BEGIN
+                    FOR part IN
+                        SELECT c.relname,
+                               to_date(substring(c.relname FROM 'privilege_history_(\d{4}_\d{2})$'), 'YYYY_MM') AS month_start
+                        FROM pg_inherits i
+                        JOIN pg_class c ON c.oid = i.inhrelid
+                        WHERE i.inhparent = 'privilege_history'::regclass
+                          AND c.relname ~ '^privilege_history_\d{4}_\d{2}$'
+                        ORDER BY 2
+                    LOOP
+                        EXIT WHEN (part.month_start + INTERVAL '1 month')::date > cutoff;
+
+                        EXECUTE format($q$
+                            INSERT INTO privilege_balance_snapshot (privilege_id, balance, operations, archived_until)
+                            SELECT privilege_id, SUM(balance_diff), COUNT(*), %L::timestamp
+                            FROM %I
+                            WHERE privilege_id IS NOT NULL
+                            GROUP BY privilege_id
+                            ON CONFLICT (privilege_id) DO UPDATE SET
+                                balance = privilege_balance_snapshot.balance + EXCLUDED.balance,
+                                operations = privilege_balance_snapshot.operations + EXCLUDED.operations,
+                                archived_until = GREATEST(privilege_balance_snapshot.archived_until, EXCLUDED.archived_until),
+                                updated_at = CURRENT_TIMESTAMP
+                        $q$, (part.month_start + INTERVAL '1 month')::date, part.relname);
+
+                        EXECUTE format('ALTER TABLE privilege_history DETACH PARTITION %I', part.relname);
+                        EXECUTE format('ALTER TABLE %I RENAME TO %I', part.relname,
+                            'privilege_history_archive_' || to_char(part.month_start, 'YYYY_MM'));
+
+                        archived := archived + 1;
+                    END LOOP;
+                    RETURN archived;
+                END
+                $fn$ LANGUAGE plpgsql
+            )SQL",
+            // Старая таблица уступает имя секционированной; последовательность id сохраняется
+            "ALTER TABLE privilege_history RENAME TO privilege_history_legacy",
+            "ALTER INDEX privilege_history_pkey RENAME TO privilege_history_legacy_pkey",
+            "DROP INDEX IF EXISTS idx_privilege_history_page",
+            "DROP INDEX IF EXISTS idx_privilege_history_ticket_uid",
+            "ALTER SEQUENCE privilege_history_id_seq OWNED BY NONE",
+            R"(
+                CREATE TABLE privilege_history
+                (
+                    id             INT         NOT NULL DEFAULT nextval('privilege_history_id_seq'),
+                    privilege_id   INT REFERENCES privilege(id),
+                    ticket_uid     uuid        NOT NULL,
+                    datetime       TIMESTAMP   NOT NULL,
+                    balance_diff   INT         NOT NULL,
+                    operation_type VARCHAR(20) NOT NULL
+                        CHECK (operation_type IN ('FILL_IN_BALANCE', 'DEBIT_THE_ACCOUNT')),
+                    PRIMARY KEY (id, datetime)
+                ) PARTITION BY RANGE (datetime)
+            )",
+            "ALTER SEQUENCE privilege_history_id_seq OWNED BY privilege_history.id",
+            // Партиции под существующие записи и на несколько месяцев вперед
+            R"SQL(
+                DO $do$
+                DECLARE
+                    month_start DATE;
+                BEGIN
+                    SELECT date_trunc('month', MIN(datetime))::date INTO month_start FROM privilege_history_legacy;
+
+                    WHILE month_start IS NOT NULL AND month_start <= CURRENT_DATE LOOP
+                        PERFORM create_privilege_history_partition(month_start);
+                        month_start := (month_start + INTERVAL '1 month')::date;
+                    END LOOP;
+                END
+                $do$
+            )SQL",
+            "SELECT ensure_privilege_history_partitions(3)",
+            R"(
+                INSERT INTO privilege_history (id, privilege_id, ticket_uid, datetime, balance_diff, operation_type)
+                SELECT id, privilege_id, ticket_uid, datetime, balance_diff, operation_type
+                FROM privilege_history_legacy
+            )",
+            "DROP TABLE privilege_history_legacy",
+            "CREATE INDEX idx_privilege_history_page ON privilege_history (privilege_id, datetime DESC, id DESC)",
+            "CREATE INDEX idx_privilege_history_ticket_uid ON privilege_history (ticket_uid)"
+        } },
+        { 6, "keep archived privilege history reachable by ticket", {
+            // Архивные партиции собираются под общим родителем: поиск операций
+            // по билету (отмена, возврат, выгрузка для отчета) читает и их
+            R"(
+                CREATE TABLE IF NOT EXISTS privilege_history_archive
+                (
+                    id             INT         NOT NULL,
+                    privilege_id   INT,
+                    ticket_uid     uuid        NOT NULL,
+                    datetime       TIMESTAMP   NOT NULL,
+                    balance_diff   INT         NOT NULL,
+                    operation_type VARCHAR(20) NOT NULL
+                ) PARTITION BY RANGE (datetime)
+            )",
+            R"SQL(
+                DO $do$
+                DECLARE
+                    part RECORD;
+                BEGIN
+                    FOR part IN
+                        SELECT c.relname,
+                               to_date(substring(c.relname FROM 'privilege_history_archive_(\d{4}_\d{2})$'), 'YYYY_MM') AS month_start
+                        FROM pg_class c
+                        WHERE c.relkind = 'r' AND NOT c.relispartition
+                          AND c.relname ~ '^privilege_history_archive_\d{4}_\d{2}$'
+                    LOOP
+                        EXECUTE format('ALTER TABLE privilege_history_archive ATTACH PARTITION %I FOR VALUES FROM (%L) TO (%L)',
+                            part.relname, part.month_start, (part.month_start + INTERVAL '1 month')::date);
+                    END LOOP;
+                END
+                $do$
+            )SQL",
+            "CREATE INDEX IF NOT EXISTS idx_privilege_history_archive_ticket_uid ON privilege_history_archive (ticket_uid)",
+            // Архивируемая партиция присоединяется к privilege_history_archive
+            R"SQL(
+                CREATE OR REPLACE FUNCTION archive_privilege_history_partitions(retention_months INT) RETURNS INT AS $fn$
+                DECLARE
+                    cutoff DATE := (date_trunc('month', CURRENT_DATE) - make_interval(months => retention_months))::date;
+                    part RECORD;
+                    archived INT := 0;
+                BEGIN
+                    FOR part IN
+                        SELECT c.relname,
+                               to_date(substring(c.relname FROM 'privilege_history_(\d{4}_\d{2})$'), 'YYYY_MM') AS month_start
+                        FROM pg_inherits i
+                        JOIN pg_class c ON c.oid = i.inhrelid
+                        WHERE i.inhparent = 'privilege_history'::regclass
+                          AND c.relname ~ '^privilege_history_\d{4}_\d{2}$'
+                        ORDER BY 2
+                    LOOP
+                        EXIT WHEN (part.month_start + INTERVAL '1 month')::date > cutoff;
+
+                        EXECUTE format($q$
+                            INSERT INTO privilege_balance_snapshot (privilege_id, balance, operations, archived_until)
+                            SELECT privilege_id, SUM(balance_diff), COUNT(*), %L::timestamp
+                            FROM %I
+                            WHERE privilege_id IS NOT NULL
+                            GROUP BY privilege_id
+                            ON CONFLICT (privilege_id) DO UPDATE SET
+                                balance = privilege_balance_snapshot.balance + EXCLUDED.balance,
+                                operations = privilege_balance_snapshot.operations + EXCLUDED.operations,
+                                archived_until = GREATEST(privilege_balance_snapshot.archived_until, EXCLUDED.archived_until),
+                                updated_at = CURRENT_TIMESTAMP
+                        $q$, (part.month_start + INTERVAL '1 month')::date, part.relname);
+
+                        EXECUTE format('ALTER TABLE privilege_history DETACH PARTITION %I', part.relname);
+                        EXECUTE format('ALTER TABLE %I RENAME TO %I', part.relname,
+                            'privilege_history_archive_' || to_char(part.month_start, 'YYYY_MM'));
+                        EXECUTE format('ALTER TABLE privilege_history_archive ATTACH PARTITION %I FOR VALUES FROM (%L) TO (%L)',
+                            'privilege_history_archive_' || to_char(part.month_start, 'YYYY_MM'),
+                            part.month_start, (part.month_start + INTERVAL '1 month')::date);
+
+                        archived := archived + 1;
+                    END LOOP;
+                    RETURN archived;
+                END
+                $fn$ LANGUAGE plpgsql
+            )SQL"
+        } }
+    };
+}
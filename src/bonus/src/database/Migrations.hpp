@@ -0,0 +1,6 @@
+#pragma once
+#include <vector>
+#include "MigrationRunner.hpp"
+
+// Миграции схемы базы данных privileges по возрастанию версии
+std::vector<Migration> bonus_migrations();
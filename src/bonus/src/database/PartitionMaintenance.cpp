@@ -0,0 +1,60 @@
+#include "PartitionMaintenance.hpp"
+#include <iostream>
+
+PartitionMaintenance::PartitionMaintenance(BonusRepository& repo, int months_ahead, int retention_months,
+    std::chrono::minutes interval)
+    : repo(repo)
+    , months_ahead(months_ahead)
+    , retention_months(retention_months)
+    , interval(interval) {
+}
+
+PartitionMaintenance::~PartitionMaintenance() {
+    stop();
+}
+
+void PartitionMaintenance::start() {
+    run_once();
+    worker = std::thread([this]() { run(); });
+}
+
+void PartitionMaintenance::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex);
+        stopping = true;
+    }
+    stop_cv.notify_all();
+
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void PartitionMaintenance::run() {
+    std::unique_lock<std::mutex> lock(stop_mutex);
+
+    while (!stop_cv.wait_for(lock, interval, [this]() { return stopping; })) {
+        lock.unlock();
+        run_once();
+        lock.lock();
+    }
+}
+
+void PartitionMaintenance::run_once() {
+    try {
+        int created = repo.ensure_history_partitions(months_ahead);
+        if (created > 0) {
+            std::cout << "Partition maintenance: created " << created << " history partitions" << std::endl;
+        }
+
+        if (retention_months > 0) {
+            int archived = repo.archive_history_partitions(retention_months);
+            if (archived > 0) {
+                std::cout << "Partition maintenance: archived " << archived << " history partitions" << std::endl;
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Partition maintenance failed: " << e.what() << std::endl;
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "BonusRepository.hpp"
+
+// Обслуживание помесячных партиций privilege_history: при старте и затем
+// раз в interval создает партиции на months_ahead месяцев вперед и, если
+// retention_months > 0, отправляет в архив партиции старше этого срока.
+class PartitionMaintenance {
+public:
+    PartitionMaintenance(BonusRepository& repo, int months_ahead, int retention_months,
+        std::chrono::minutes interval);
+    ~PartitionMaintenance();
+
+    PartitionMaintenance(const PartitionMaintenance&) = delete;
+    PartitionMaintenance& operator=(const PartitionMaintenance&) = delete;
+
+    void start();
+    void stop();
+
+    // Один проход обслуживания; ошибки логируются
+    void run_once();
+
+private:
+    void run();
+
+    BonusRepository& repo;
+    int months_ahead;
+    int retention_months;
+    std::chrono::minutes interval;
+
+    std::thread worker;
+    std::mutex stop_mutex;
+    std::condition_variable stop_cv;
+    bool stopping = false;
+};
@@ -0,0 +1,126 @@
+#include "ReplicaRouter.hpp"
+#include <iostream>
+
+ReplicaRouter::ReplicaRouter(Options options, ConnectionPool::Initializer initializer)
+    : options(std::move(options))
+    , initializer(std::move(initializer)) {
+
+    for (const auto& connection_string : this->options.connection_strings) {
+        auto replica = std::make_unique<Replica>();
+        replica->connection_string = connection_string;
+        replicas.push_back(std::move(replica));
+    }
+}
+
+ReplicaRouter::~ReplicaRouter() {
+    stop();
+}
+
+void ReplicaRouter::start() {
+    poll();
+    poller = std::thread([this]() { run(); });
+}
+
+void ReplicaRouter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex);
+        stopping = true;
+    }
+    stop_cv.notify_all();
+
+    if (poller.joinable()) {
+        poller.join();
+    }
+}
+
+void ReplicaRouter::run() {
+    std::unique_lock<std::mutex> lock(stop_mutex);
+
+    while (!stop_cv.wait_for(lock, options.poll_interval, [this]() { return stopping; })) {
+        lock.unlock();
+        poll();
+        lock.lock();
+    }
+}
+
+void ReplicaRouter::poll() {
+    for (auto& replica : replicas) {
+        try {
+            // Пул создается при первом успешном подключении к реплике
+            if (!replica->owned_pool) {
+                replica->owned_pool = std::make_unique<ConnectionPool>(
+                    replica->connection_string, options.pool_size, initializer);
+                replica->pool.store(replica->owned_pool.get());
+            }
+
+            auto connection = replica->owned_pool->acquire();
+            pqxx::nontransaction txn(*connection);
+
+            // Реплика догнала primary - отставание 0, иначе время с последней примененной транзакции
+            auto result = txn.exec(R"(
+                SELECT CASE
+                    WHEN NOT pg_is_in_recovery() THEN 0
+                    WHEN pg_last_wal_receive_lsn() = pg_last_wal_replay_lsn() THEN 0
+                    ELSE COALESCE(EXTRACT(EPOCH FROM now() - pg_last_xact_replay_timestamp()) * 1000, 0)
+                END::bigint AS lag_ms
+            )");
+
+            replica->lag_ms.store(result[0]["lag_ms"].as<long long>());
+            replica->healthy.store(true);
+        }
+        catch (const std::exception& e) {
+            if (replica->healthy.exchange(false)) {
+                std::cerr << "Replica unavailable, reading from primary: " << e.what() << std::endl;
+            }
+        }
+    }
+
+    // Записи старше окна read-your-writes больше не нужны
+    auto expired = std::chrono::steady_clock::now() - options.read_your_writes_window;
+
+    std::lock_guard<std::mutex> lock(writes_mutex);
+    for (auto it = recent_writes.begin(); it != recent_writes.end();) {
+        it = it->second < expired ? recent_writes.erase(it) : std::next(it);
+    }
+}
+
+ConnectionPool* ReplicaRouter::pool_for_read(const std::string& username) {
+    if (!username.empty()) {
+        std::lock_guard<std::mutex> lock(writes_mutex);
+
+        auto it = recent_writes.find(username);
+        if (it != recent_writes.end() &&
+            std::chrono::steady_clock::now() - it->second < options.read_your_writes_window) {
+            return nullptr;
+        }
+    }
+
+    std::size_t start = next_replica.fetch_add(1, std::memory_order_relaxed);
+
+    for (std::size_t i = 0; i < replicas.size(); ++i) {
+        auto& replica = replicas[(start + i) % replicas.size()];
+
+        if (replica->healthy.load() && replica->lag_ms.load() <= options.max_lag.count()) {
+            return replica->pool.load();
+        }
+    }
+
+    return nullptr;
+}
+
+void ReplicaRouter::record_write(const std::string& username) {
+    if (username.empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(writes_mutex);
+    recent_writes[username] = std::chrono::steady_clock::now();
+}
+
+void ReplicaRouter::report_failure(ConnectionPool* replica_pool) {
+    for (auto& replica : replicas) {
+        if (replica->pool.load() == replica_pool) {
+            replica->healthy.store(false);
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <pqxx/pqxx>
+
+// Реестр именованных prepared statements.
+// Все запросы регистрируются до создания пула соединений, затем готовятся
+// на каждом соединении и вызываются по имени. Для каждого запроса ведется
+// счетчик выполнений.
+class StatementRegistry {
+public:
+    void add(const std::string& name, const std::string& sql);
+
+    // Вызывается пулом для каждого нового соединения
+    void prepare(pqxx::connection& connection) const;
+
+    pqxx::result exec(pqxx::transaction_base& txn, const std::string& name,
+        const pqxx::params& params = pqxx::params{});
+
+    std::vector<std::pair<std::string, std::uint64_t>> get_execution_counts() const;
+
+private:
+    struct Statement {
+        std::string sql;
+        std::atomic<std::uint64_t> executions{ 0 };
+    };
+
+    std::unordered_map<std::string, std::unique_ptr<Statement>> statements;
+};
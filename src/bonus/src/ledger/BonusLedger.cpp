@@ -0,0 +1,369 @@
+#include "BonusLedger.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+
+BonusLedger::BonusLedger(BonusRepository& repo, std::string journal_path,
+    std::size_t shard_count, std::chrono::milliseconds flush_interval, LoyaltyStats* stats)
+    : repo(repo)
+    , journal_path(std::move(journal_path))
+    , flush_interval(flush_interval)
+    , stats(stats)
+    , shards(new Shard[shard_count > 0 ? shard_count : 1])
+    , shard_count(shard_count > 0 ? shard_count : 1) {
+}
+
+BonusLedger::~BonusLedger() {
+    stop();
+
+    if (journal_fd >= 0) {
+        ::close(journal_fd);
+    }
+}
+
+bool BonusLedger::valid_ticket_uid(const std::string& value) {
+    if (value.size() != 36) {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        bool dash = i == 8 || i == 13 || i == 18 || i == 23;
+        if (dash ? value[i] != '-' : !std::isxdigit(static_cast<unsigned char>(value[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+BonusLedger::Shard& BonusLedger::shard_for(const std::string& username) const {
+    return shards[std::hash<std::string>{}(username) % shard_count];
+}
+
+std::vector<std::string> BonusLedger::list_segments() const {
+    namespace fs = std::filesystem;
+
+    std::vector<std::string> segments;
+    fs::path base(journal_path);
+    fs::path dir = base.has_parent_path() ? base.parent_path() : fs::path(".");
+    const std::string prefix = base.filename().string() + ".";
+
+    std::error_code ec;
+    if (fs::exists(base, ec)) {
+        segments.push_back(journal_path);
+    }
+
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        const std::string name = it->path().filename().string();
+
+        if (name.size() > prefix.size() && name.compare(0, prefix.size(), prefix) == 0 &&
+            std::all_of(name.begin() + prefix.size(), name.end(),
+                [](unsigned char ch) { return std::isdigit(ch); })) {
+            segments.push_back(it->path().string());
+        }
+    }
+
+    if (ec) {
+        throw std::runtime_error("Cannot list ledger journal segments: " + ec.message());
+    }
+
+    return segments;
+}
+
+int BonusLedger::open_segment(std::int64_t first_seq, std::string& path) const {
+    path = journal_path + "." + std::to_string(first_seq);
+    return ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+}
+
+std::vector<LedgerEntry> BonusLedger::read_segment(const std::string& path) {
+    std::vector<LedgerEntry> entries;
+    std::ifstream in(path);
+    std::string line;
+
+    while (std::getline(in, line)) {
+        if (line.empty()) {
+            continue;
+        }
+
+        try {
+            entries.push_back(LedgerEntry::from_json(nlohmann::json::parse(line)));
+        }
+        catch (const std::exception& e) {
+            // Недописанная последняя строка после падения процесса
+            std::cerr << "Ledger journal: skipping damaged record: " << e.what() << std::endl;
+            break;
+        }
+    }
+
+    return entries;
+}
+
+void BonusLedger::recover() {
+    std::int64_t checkpoint = repo.get_ledger_checkpoint();
+    std::vector<LedgerEntry> replay;
+    auto segments = list_segments();
+
+    for (const auto& segment : segments) {
+        for (auto& entry : read_segment(segment)) {
+            last_seq = std::max(last_seq, entry.seq);
+
+            if (entry.seq > checkpoint) {
+                replay.push_back(std::move(entry));
+            }
+        }
+    }
+
+    last_seq = std::max(last_seq, checkpoint);
+
+    // Сегменты могли остаться после нескольких неудачных записей в БД
+    std::sort(replay.begin(), replay.end(),
+        [](const LedgerEntry& a, const LedgerEntry& b) { return a.seq < b.seq; });
+
+    if (!replay.empty()) {
+        repo.persist_ledger_entries(replay);
+        std::cout << "Ledger: replayed " << replay.size() << " journal records" << std::endl;
+    }
+
+    // Все операции журнала есть в БД
+    for (const auto& segment : segments) {
+        if (::unlink(segment.c_str()) != 0 && errno != ENOENT) {
+            throw std::runtime_error("Cannot remove ledger journal " + segment + ": " + std::strerror(errno));
+        }
+    }
+
+    journal_fd = open_segment(last_seq + 1, segment_path);
+    if (journal_fd < 0) {
+        throw std::runtime_error("Cannot open ledger journal " + segment_path + ": " + std::strerror(errno));
+    }
+
+    std::size_t loaded = 0;
+
+    for (auto& row : repo.get_all_balances()) {
+        Shard& shard = shard_for(row.username);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.accounts[row.username] = Account{ row.balance, row.status };
+        ++loaded;
+    }
+
+    std::cout << "Ledger: loaded " << loaded << " accounts, last operation " << last_seq << std::endl;
+}
+
+void BonusLedger::start() {
+    flusher = std::thread([this]() { run(); });
+}
+
+void BonusLedger::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex);
+        if (stopping) {
+            return;
+        }
+        stopping = true;
+    }
+    stop_cv.notify_all();
+
+    if (flusher.joinable()) {
+        flusher.join();
+    }
+
+    // Последние операции - в БД до выхода
+    flush();
+}
+
+void BonusLedger::run() {
+    std::unique_lock<std::mutex> lock(stop_mutex);
+
+    while (!stop_cv.wait_for(lock, flush_interval, [this]() { return stopping; })) {
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+std::optional<BonusLedger::Account> BonusLedger::get(const std::string& username) const {
+    Shard& shard = shard_for(username);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.accounts.find(username);
+    if (it == shard.accounts.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::optional<BonusLedger::Account> BonusLedger::apply(const std::string& username,
+    const std::string& ticket_uid,
+    int balance_diff,
+    const std::string& operation_type) {
+
+    std::string valid_operation_type = operation_type;
+    if (operation_type == "FILLED_BY_MONEY") {
+        valid_operation_type = "FILL_IN_BALANCE";
+    }
+
+    // Операция, которую БД не примет, остановила бы запись журнала
+    // (username - VARCHAR(80) NOT NULL)
+    if (username.empty() || username.size() > 80 || !valid_ticket_uid(ticket_uid) ||
+        (valid_operation_type != "FILL_IN_BALANCE" && valid_operation_type != "DEBIT_THE_ACCOUNT")) {
+        throw std::invalid_argument("Invalid ledger operation");
+    }
+
+    Shard& shard = shard_for(username);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    // Счет появляется только вместе с принятой операцией
+    auto existing = shard.accounts.find(username);
+    Account current = existing != shard.accounts.end() ? existing->second : Account{};
+
+    int new_balance = current.balance + balance_diff;
+
+    if (new_balance < 0) {
+        return std::nullopt;
+    }
+
+    LedgerEntry entry;
+    entry.username = username;
+    entry.ticket_uid = ticket_uid;
+    entry.balance_diff = balance_diff;
+    entry.balance = new_balance;
+    entry.status = BonusRepository::get_privilege_status(new_balance);
+    entry.operation_type = valid_operation_type;
+    entry.timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    // Под блокировкой шарда - порядок операций пользователя в журнале
+    // совпадает с порядком применения
+    append_journal(entry);
+
+    auto [it, created] = shard.accounts.try_emplace(username);
+    Account& account = it->second;
+
+    if (stats) {
+        if (created) {
+            stats->add_account(account.status, account.balance);
+        }
+        stats->on_account_change(account.status, account.balance, entry.status, new_balance);
+        stats->record_operations(std::max(balance_diff, 0), std::max(-balance_diff, 0), 1);
+    }
+
+    account.balance = new_balance;
+    account.status = entry.status;
+
+    return account;
+}
+
+void BonusLedger::append_journal(LedgerEntry& entry) {
+    std::lock_guard<std::mutex> lock(journal_mutex);
+
+    entry.seq = last_seq + 1;
+
+    std::string line = entry.to_json().dump();
+    line.push_back('\n');
+
+    // Один write на запись: после падения процесса запись либо в файле целиком,
+    // либо обрезана в конце (такая строка пропускается при восстановлении)
+    const char* data = line.data();
+    std::size_t left = line.size();
+
+    while (left > 0) {
+        ssize_t written = ::write(journal_fd, data, left);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Ledger journal write failed: " + std::string(std::strerror(errno)));
+        }
+        data += written;
+        left -= static_cast<std::size_t>(written);
+    }
+
+    last_seq = entry.seq;
+    unflushed.push_back(entry);
+}
+
+void BonusLedger::sync() {
+    flush();
+}
+
+void BonusLedger::flush() {
+    std::lock_guard<std::mutex> flush_lock(flush_mutex);
+
+    std::vector<LedgerEntry> batch;
+    int batch_fd = -1;
+    {
+        std::lock_guard<std::mutex> lock(journal_mutex);
+        batch.swap(unflushed);
+
+        if (batch.empty()) {
+            return;
+        }
+
+        // Новые операции идут в новый сегмент: старый удаляется после commit,
+        // и журнал не растет при постоянном потоке операций
+        std::string next_path;
+        int next_fd = open_segment(last_seq + 1, next_path);
+
+        if (next_fd >= 0) {
+            batch_fd = journal_fd;
+            retired_segments.push_back(segment_path);
+            journal_fd = next_fd;
+            segment_path = next_path;
+        }
+        else {
+            std::cerr << "Cannot open ledger journal " << next_path << ": " << std::strerror(errno) << std::endl;
+        }
+    }
+
+    int sync_fd = batch_fd >= 0 ? batch_fd : journal_fd;
+    if (::fsync(sync_fd) != 0) {
+        std::cerr << "Ledger journal fsync failed: " << std::strerror(errno) << std::endl;
+    }
+    if (batch_fd >= 0) {
+        ::close(batch_fd);
+    }
+
+    try {
+        repo.persist_ledger_entries(batch);
+    }
+    catch (const std::exception& e) {
+        // Операции остаются в журнале; повтор на следующем цикле
+        std::cerr << "Ledger flush failed, will retry: " << e.what() << std::endl;
+
+        std::lock_guard<std::mutex> lock(journal_mutex);
+        batch.insert(batch.end(),
+            std::make_move_iterator(unflushed.begin()), std::make_move_iterator(unflushed.end()));
+        unflushed.swap(batch);
+        return;
+    }
+
+    // Операции закрытых сегментов есть в БД - файлы больше не нужны для восстановления
+    for (const auto& segment : retired_segments) {
+        if (::unlink(segment.c_str()) != 0 && errno != ENOENT) {
+            std::cerr << "Ledger journal remove failed: " << std::strerror(errno) << std::endl;
+        }
+    }
+    retired_segments.clear();
+}
+
+std::size_t BonusLedger::size() const {
+    std::size_t total = 0;
+
+    for (std::size_t i = 0; i < shard_count; ++i) {
+        std::lock_guard<std::mutex> lock(shards[i].mutex);
+        total += shards[i].accounts.size();
+    }
+
+    return total;
+}
+
+std::size_t BonusLedger::pending() const {
+    std::lock_guard<std::mutex> lock(journal_mutex);
+    return unflushed.size();
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "../database/BonusRepository.hpp"
+#include "../models/LedgerEntry.hpp"
+#include "../stats/LoyaltyStats.hpp"
+
+// Бонусные балансы в памяти с отложенной записью в БД.
+// Счета разбиты на шарды с собственным mutex; операции одного пользователя
+// упорядочены блокировкой его шарда. Каждая операция сразу дописывается
+// в текущий сегмент журнала (файл "<journal_path>.<seq первой операции>").
+// Фоновый поток раз в flush_interval переключает запись на новый сегмент,
+// делает fsync старого и записывает его операции в БД одной транзакцией
+// вместе с checkpoint (номер последней записанной операции); после commit
+// старый сегмент удаляется. При старте операции всех сегментов после
+// checkpoint дописываются в БД, затем балансы загружаются из БД.
+// Режим рассчитан на единственный экземпляр Bonus Service.
+class BonusLedger {
+public:
+    struct Account {
+        int balance = 0;
+        std::string status = "BRONZE";
+    };
+
+    BonusLedger(BonusRepository& repo, std::string journal_path,
+        std::size_t shard_count = 64,
+        std::chrono::milliseconds flush_interval = std::chrono::milliseconds(200),
+        LoyaltyStats* stats = nullptr);
+    ~BonusLedger();
+
+    BonusLedger(const BonusLedger&) = delete;
+    BonusLedger& operator=(const BonusLedger&) = delete;
+
+    // Восстановление по журналу и загрузка балансов; вызывается до start()
+    void recover();
+
+    void start();
+    void stop();
+
+    std::optional<Account> get(const std::string& username) const;
+
+    // Изменение баланса; счет создается при первой принятой операции.
+    // nullopt - баланс ушел бы в минус, ничего не изменено.
+    // std::invalid_argument - некорректные username, ticket_uid или тип операции.
+    std::optional<Account> apply(const std::string& username,
+        const std::string& ticket_uid,
+        int balance_diff,
+        const std::string& operation_type);
+
+    // Записать накопленные операции в БД сейчас, не дожидаясь фонового потока
+    void sync();
+
+    std::size_t size() const;
+    // Операции, еще не записанные в БД
+    std::size_t pending() const;
+
+private:
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Account> accounts;
+    };
+
+    Shard& shard_for(const std::string& username) const;
+    static bool valid_ticket_uid(const std::string& value);
+
+    // Сегменты журнала на диске (и файл journal_path прежнего формата)
+    std::vector<std::string> list_segments() const;
+    static std::vector<LedgerEntry> read_segment(const std::string& path);
+    // Открывает новый сегмент для операций начиная с first_seq; -1 при ошибке
+    int open_segment(std::int64_t first_seq, std::string& path) const;
+    void append_journal(LedgerEntry& entry);
+    void run();
+    void flush();
+
+    BonusRepository& repo;
+    std::string journal_path;
+    std::chrono::milliseconds flush_interval;
+
+    // Агрегаты обновляются при применении операции, а не при записи в БД
+    LoyaltyStats* stats;
+
+    std::unique_ptr<Shard[]> shards;
+    std::size_t shard_count;
+
+    // Журнал: текущий сегмент, номер последней операции и операции, ожидающие записи в БД
+    mutable std::mutex journal_mutex;
+    int journal_fd = -1;
+    std::string segment_path;
+    std::int64_t last_seq = 0;
+    std::vector<LedgerEntry> unflushed;
+
+    // Записи в БД идут по одной - checkpoint не уменьшается
+    std::mutex flush_mutex;
+    // Закрытые сегменты, операции которых еще не подтверждены БД (под flush_mutex)
+    std::vector<std::string> retired_segments;
+
+    std::thread flusher;
+    std::mutex stop_mutex;
+    std::condition_variable stop_cv;
+    bool stopping = false;
+};
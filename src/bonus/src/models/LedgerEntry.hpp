@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <nlohmann/json.hpp>
+
+// Операция бонусного журнала: изменение баланса и баланс после него
+struct LedgerEntry {
+    std::int64_t seq = 0;
+    std::string username;
+    std::string ticket_uid;
+    int balance_diff = 0;
+    int balance = 0;
+    std::string status;
+    std::string operation_type;
+    // Время операции, мс от эпохи
+    std::int64_t timestamp_ms = 0;
+
+    nlohmann::json to_json() const {
+        return {
+            {"seq", seq},
+            {"username", username},
+            {"ticketUid", ticket_uid},
+            {"balanceDiff", balance_diff},
+            {"balance", balance},
+            {"status", status},
+            {"operationType", operation_type},
+            {"ts", timestamp_ms}
+        };
+    }
+
+    static LedgerEntry from_json(const nlohmann::json& j) {
+        LedgerEntry entry;
+        entry.seq = j.at("seq").get<std::int64_t>();
+        entry.username = j.at("username").get<std::string>();
+        entry.ticket_uid = j.at("ticketUid").get<std::string>();
+        entry.balance_diff = j.at("balanceDiff").get<int>();
+        entry.balance = j.at("balance").get<int>();
+        entry.status = j.at("status").get<std::string>();
+        entry.operation_type = j.at("operationType").get<std::string>();
+        entry.timestamp_ms = j.at("ts").get<std::int64_t>();
+        return entry;
+    }
+};
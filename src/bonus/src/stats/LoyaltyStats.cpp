@@ -0,0 +1,121 @@
+#include "LoyaltyStats.hpp"
+#include <chrono>
+
+namespace {
+    const char* const tier_names[] = { "BRONZE", "SILVER", "GOLD" };
+}
+
+LoyaltyStats::LoyaltyStats() {
+    for (std::size_t i = 0; i < tier_count; ++i) {
+        accounts[i] = 0;
+        balances[i] = 0;
+    }
+}
+
+std::size_t LoyaltyStats::tier_index(const std::string& status) {
+    if (status == "GOLD") return 2;
+    if (status == "SILVER") return 1;
+    return 0;
+}
+
+std::int64_t LoyaltyStats::current_minute() {
+    return std::chrono::duration_cast<std::chrono::minutes>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void LoyaltyStats::load(const std::string& status, std::int64_t count, std::int64_t balance) {
+    std::size_t tier = tier_index(status);
+    accounts[tier] += count;
+    balances[tier] += balance;
+}
+
+void LoyaltyStats::add_account(const std::string& status, std::int64_t balance) {
+    std::size_t tier = tier_index(status);
+    accounts[tier] += 1;
+    balances[tier] += balance;
+}
+
+void LoyaltyStats::on_account_change(const std::string& old_status, std::int64_t old_balance,
+    const std::string& new_status, std::int64_t new_balance) {
+    std::size_t old_tier = tier_index(old_status);
+    std::size_t new_tier = tier_index(new_status);
+
+    if (old_tier != new_tier) {
+        accounts[old_tier] -= 1;
+        accounts[new_tier] += 1;
+    }
+
+    balances[old_tier] -= old_balance;
+    balances[new_tier] += new_balance;
+}
+
+void LoyaltyStats::record_operations(std::int64_t accrued, std::int64_t debited, std::int64_t operations) {
+    total_accrued += accrued;
+    total_debited += debited;
+    total_operations += operations;
+
+    std::int64_t minute = current_minute();
+    Bucket& bucket = buckets[static_cast<std::size_t>(minute) % bucket_count];
+
+    // Первая операция новой минуты обнуляет ячейку; операции, попавшие
+    // между сменой минуты и обнулением, теряются - итоги приблизительные
+    std::int64_t seen = bucket.minute.load();
+    if (seen != minute && bucket.minute.compare_exchange_strong(seen, minute)) {
+        bucket.accrued = 0;
+        bucket.debited = 0;
+        bucket.operations = 0;
+    }
+
+    bucket.accrued += accrued;
+    bucket.debited += debited;
+    bucket.operations += operations;
+}
+
+nlohmann::json LoyaltyStats::to_json() const {
+    nlohmann::json tiers = nlohmann::json::object();
+    std::int64_t total_accounts = 0;
+    std::int64_t outstanding = 0;
+
+    for (std::size_t i = 0; i < tier_count; ++i) {
+        std::int64_t tier_accounts = accounts[i].load();
+        std::int64_t tier_balance = balances[i].load();
+
+        tiers[tier_names[i]] = { {"users", tier_accounts}, {"balance", tier_balance} };
+        total_accounts += tier_accounts;
+        outstanding += tier_balance;
+    }
+
+    // Последний час, старые минуты первыми; текущая минута неполная
+    std::int64_t now = current_minute();
+    std::int64_t hour_accrued = 0;
+    nlohmann::json last_hour = nlohmann::json::array();
+
+    for (std::int64_t minute = now - static_cast<std::int64_t>(bucket_count) + 1; minute <= now; ++minute) {
+        const Bucket& bucket = buckets[static_cast<std::size_t>(minute) % bucket_count];
+
+        if (bucket.minute.load() != minute) {
+            continue;
+        }
+
+        std::int64_t accrued = bucket.accrued.load();
+        hour_accrued += accrued;
+
+        last_hour.push_back({
+            {"minute", minute * 60},
+            {"accrued", accrued},
+            {"debited", bucket.debited.load()},
+            {"operations", bucket.operations.load()}
+        });
+    }
+
+    return {
+        {"tiers", tiers},
+        {"users", total_accounts},
+        {"outstandingBalance", outstanding},
+        {"accrued", total_accrued.load()},
+        {"debited", total_debited.load()},
+        {"operations", total_operations.load()},
+        {"accrualPerMinute", static_cast<double>(hour_accrued) / bucket_count},
+        {"lastHour", last_hour}
+    };
+}
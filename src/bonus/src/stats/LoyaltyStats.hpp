@@ -0,0 +1,50 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <nlohmann/json.hpp>
+
+// Агрегаты программы лояльности, которые обновляются вместе с балансами:
+// число счетов по статусам, сумма балансов, итоги начислений и списаний
+// и поминутные итоги за последний час. Чтение - O(1), без запросов к БД.
+// Начальные значения - один агрегирующий запрос при старте (load).
+class LoyaltyStats {
+public:
+    LoyaltyStats();
+
+    // Начальное состояние по статусу: число счетов и сумма их балансов
+    void load(const std::string& status, std::int64_t count, std::int64_t balance);
+
+    void add_account(const std::string& status, std::int64_t balance);
+    void on_account_change(const std::string& old_status, std::int64_t old_balance,
+        const std::string& new_status, std::int64_t new_balance);
+
+    // Начислено и списано (положительные суммы) за operations операций
+    void record_operations(std::int64_t accrued, std::int64_t debited, std::int64_t operations);
+
+    nlohmann::json to_json() const;
+
+private:
+    static constexpr std::size_t tier_count = 3;
+    static constexpr std::size_t bucket_count = 60;
+
+    struct Bucket {
+        std::atomic<std::int64_t> minute{ -1 };
+        std::atomic<std::int64_t> accrued{ 0 };
+        std::atomic<std::int64_t> debited{ 0 };
+        std::atomic<std::int64_t> operations{ 0 };
+    };
+
+    static std::size_t tier_index(const std::string& status);
+    static std::int64_t current_minute();
+
+    std::array<std::atomic<std::int64_t>, tier_count> accounts;
+    std::array<std::atomic<std::int64_t>, tier_count> balances;
+
+    std::atomic<std::int64_t> total_accrued{ 0 };
+    std::atomic<std::int64_t> total_debited{ 0 };
+    std::atomic<std::int64_t> total_operations{ 0 };
+
+    std::array<Bucket, bucket_count> buckets;
+};
@@ -4,7 +4,10 @@
 // Health check
 crow::response FlightController::health_check() {
     try {
-        if (!flight_repository.is_connected()) {
+        // В режиме каталога сервис отвечает и без БД
+        bool catalog_ready = flight_catalog && flight_catalog->is_loaded();
+
+        if (!catalog_ready && !flight_repository.is_connected()) {
             return crow::response(500, "Database not connected");
         }
         
@@ -19,21 +22,58 @@ crow::response FlightController::health_check() {
     }
 }
 
-nlohmann::json FlightController::create_pagination_response(const FlightRepository::PaginationResult& result) {
-    nlohmann::json response = {
-        {"page", result.page},
-        {"pageSize", result.page_size},
-        {"totalElements", result.total_count}
-    };
-    
-    nlohmann::json items = nlohmann::json::array();
-
-    for (const auto& flight : result.flights) {
-        items.push_back(flight.to_api_json());
+// Счетчики выполнений prepared statements
+crow::response FlightController::get_statement_stats() {
+    nlohmann::json response = nlohmann::json::object();
+
+    for (const auto& [name, executions] : flight_repository.get_statement_stats()) {
+        response[name] = executions;
+    }
+
+    crow::response res(200, response.dump());
+    res.set_header("Content-Type", "application/json");
+    return res;
+}
+
+// Ответ собирается склейкой готовых JSON-фрагментов рейсов в заранее
+// выделенный буфер. Порядок ключей совпадает с nlohmann::json::dump().
+std::string FlightController::create_pagination_response(const FlightRepository::PaginationResult& result) {
+    std::vector<std::shared_ptr<const std::string>> built;
+    const auto* fragments = &result.fragments;
+
+    if (fragments->empty() && !result.flights.empty()) {
+        built.reserve(result.flights.size());
+        for (const auto& flight : result.flights) {
+            built.push_back(std::make_shared<const std::string>(flight.to_api_json_fragment()));
+        }
+        fragments = &built;
+    }
+
+    std::size_t size = 64;
+    for (const auto& fragment : *fragments) {
+        size += fragment->size() + 1;
+    }
+
+    std::string response;
+    response.reserve(size);
+
+    response.append("{\"items\":[");
+
+    for (std::size_t i = 0; i < fragments->size(); ++i) {
+        if (i > 0) {
+            response.push_back(',');
+        }
+        response.append(*(*fragments)[i]);
     }
-    
-    response["items"] = items;
-    
+
+    response.append("],\"page\":");
+    json_writer::append_int(response, result.page);
+    response.append(",\"pageSize\":");
+    json_writer::append_int(response, result.page_size);
+    response.append(",\"totalElements\":");
+    json_writer::append_int(response, result.total_count);
+    response.push_back('}');
+
     return response;
 }
 
@@ -61,11 +101,11 @@ crow::response FlightController::get_flights(const crow::request& req) {
             if (size > 100) size = 100; 
         }
         
-        auto result = flight_repository.get_flights_paginated(page, size);
-        
-        auto response_json = create_pagination_response(result);
+        auto result = flight_catalog
+            ? flight_catalog->get_flights_paginated(page, size)
+            : flight_repository.get_flights_paginated(page, size);
         
-        crow::response res(200, response_json.dump());
+        crow::response res(200, create_pagination_response(result));
         res.set_header("Content-Type", "application/json");
         
         return res;
@@ -86,15 +126,270 @@ crow::response FlightController::get_flights(const crow::request& req) {
     }
 }
 
+// GET /api/v1/flights/search?from= &to= &dateFrom= &dateTo= &minPrice= &maxPrice= &sort= &page= &size=
+crow::response FlightController::search_flights(const crow::request& req) {
+    try {
+        if (!flight_catalog) {
+            nlohmann::json error = {
+                {"message", "Flight search requires catalog mode"}
+            };
+            return crow::response(503, error.dump());
+        }
+
+        FlightCatalog::SearchQuery query;
+
+        auto param = [&req](const char* name) {
+            const char* value = req.url_params.get(name);
+            return value ? std::string(value) : std::string();
+        };
+
+        query.from = param("from");
+        query.to = param("to");
+        query.date_from = param("dateFrom");
+        query.date_to = param("dateTo");
+
+        if (!param("minPrice").empty()) query.min_price = std::stoi(param("minPrice"));
+        if (!param("maxPrice").empty()) query.max_price = std::stoi(param("maxPrice"));
+        if (!param("page").empty()) query.page = std::stoi(param("page"));
+        if (!param("size").empty()) query.page_size = std::stoi(param("size"));
+
+        std::string sort = param("sort");
+
+        if (sort.empty() || sort == "date") {
+            query.sort = FlightCatalog::SortOrder::DateAsc;
+        }
+        else if (sort == "-date") {
+            query.sort = FlightCatalog::SortOrder::DateDesc;
+        }
+        else if (sort == "price") {
+            query.sort = FlightCatalog::SortOrder::PriceAsc;
+        }
+        else if (sort == "-price") {
+            query.sort = FlightCatalog::SortOrder::PriceDesc;
+        }
+        else {
+            throw std::invalid_argument("Unknown sort: " + sort);
+        }
+
+        auto result = flight_catalog->search(query);
+
+        crow::response res(200, create_pagination_response(result));
+        res.set_header("Content-Type", "application/json");
+
+        return res;
+
+    } catch (const std::invalid_argument& e) {
+        nlohmann::json error = {
+            {"message", "Invalid query parameters"},
+            {"error", e.what()}
+        };
+        return crow::response(400, error.dump());
+
+    } catch (const std::out_of_range& e) {
+        nlohmann::json error = {
+            {"message", "Invalid query parameters"},
+            {"error", "Numeric parameter is out of range"}
+        };
+        return crow::response(400, error.dump());
+
+    } catch (const std::exception& e) {
+        nlohmann::json error = {
+            {"message", "Internal server error"},
+            {"error", e.what()}
+        };
+        return crow::response(500, error.dump());
+    }
+}
+
+// POST /api/v1/flights/import?format=csv|ndjson
+// Формат можно передать и через Content-Type: text/csv, application/x-ndjson
+crow::response FlightController::import_flights(const crow::request& req) {
+    try {
+        std::optional<FlightImporter::Format> format;
+
+        if (req.url_params.get("format")) {
+            format = FlightImporter::parse_format(req.url_params.get("format"));
+        }
+        else {
+            std::string content_type = req.get_header_value("Content-Type");
+
+            if (content_type.rfind("text/csv", 0) == 0) {
+                format = FlightImporter::Format::Csv;
+            }
+            else if (content_type.rfind("application/x-ndjson", 0) == 0) {
+                format = FlightImporter::Format::Ndjson;
+            }
+        }
+
+        if (!format) {
+            throw std::invalid_argument("Unknown import format");
+        }
+
+        std::istringstream input(req.body);
+
+        FlightImporter importer(flight_repository);
+        auto report = importer.import(input, *format);
+
+        crow::response res(200, report.to_json().dump());
+        res.set_header("Content-Type", "application/json");
+
+        return res;
+
+    } catch (const std::invalid_argument& e) {
+        nlohmann::json error = {
+            {"message", "Invalid import request"},
+            {"error", e.what()}
+        };
+        return crow::response(400, error.dump());
+
+    } catch (const std::exception& e) {
+        nlohmann::json error = {
+            {"message", "Internal server error"},
+            {"error", e.what()}
+        };
+        return crow::response(500, error.dump());
+    }
+}
+
+namespace {
+    crow::response seats_response(const std::string& flight_number, const SeatInventory::Outcome& outcome) {
+        nlohmann::json response = {
+            {"flightNumber", flight_number},
+            {"seatsTotal", outcome.availability.total},
+            {"seatsRemaining", outcome.availability.remaining}
+        };
+
+        int status = 200;
+
+        if (outcome.status == SeatInventory::Status::NotFound) {
+            status = 404;
+            response = { {"message", "Flight not found"} };
+        }
+        else if (outcome.status == SeatInventory::Status::SoldOut) {
+            status = 409;
+            response["message"] = "Not enough seats";
+        }
+        else if (outcome.status == SeatInventory::Status::Closed) {
+            status = 409;
+            response["message"] = "Flight is closed";
+        }
+
+        crow::response res(status, response.dump());
+        res.set_header("Content-Type", "application/json");
+        return res;
+    }
+}
+
+// GET /api/v1/flights/{flightNumber}/seats
+crow::response FlightController::get_seats(const std::string& flight_number) {
+    try {
+        if (!seat_inventory) {
+            return crow::response(503, nlohmann::json{ {"message", "Seat inventory is disabled"} }.dump());
+        }
+
+        return seats_response(flight_number, seat_inventory->get_availability(flight_number));
+
+    } catch (const std::exception& e) {
+        nlohmann::json error = {
+            {"message", "Internal server error"},
+            {"error", e.what()}
+        };
+        return crow::response(500, error.dump());
+    }
+}
+
+// POST /api/v1/flights/{flightNumber}/seats/reserve | release
+// Тело (необязательно): {"seats": n}, по умолчанию одно место
+crow::response FlightController::change_seats(const crow::request& req, const std::string& flight_number, bool reserve) {
+    try {
+        if (!seat_inventory) {
+            return crow::response(503, nlohmann::json{ {"message", "Seat inventory is disabled"} }.dump());
+        }
+
+        int seats = 1;
+
+        if (!req.body.empty()) {
+            auto json_body = nlohmann::json::parse(req.body);
+
+            if (json_body.contains("seats")) {
+                if (!json_body["seats"].is_number_integer()) {
+                    throw std::invalid_argument("seats must be an integer");
+                }
+                seats = json_body["seats"];
+            }
+        }
+
+        if (seats < 1) {
+            throw std::invalid_argument("seats must be positive");
+        }
+
+        auto outcome = reserve
+            ? seat_inventory->reserve(flight_number, seats)
+            : seat_inventory->release(flight_number, seats);
+
+        return seats_response(flight_number, outcome);
+
+    } catch (const nlohmann::json::exception& e) {
+        nlohmann::json error = {
+            {"message", "Invalid request body"},
+            {"error", e.what()}
+        };
+        return crow::response(400, error.dump());
+
+    } catch (const std::invalid_argument& e) {
+        nlohmann::json error = {
+            {"message", "Invalid request body"},
+            {"error", e.what()}
+        };
+        return crow::response(400, error.dump());
+
+    } catch (const std::exception& e) {
+        nlohmann::json error = {
+            {"message", "Internal server error"},
+            {"error", e.what()}
+        };
+        return crow::response(500, error.dump());
+    }
+}
+
+// POST /api/v1/flights/{flightNumber}/close
+// Закрывает продажу билетов на рейс (перед его отменой)
+crow::response FlightController::close_flight(const std::string& flight_number) {
+    try {
+        if (!seat_inventory) {
+            return crow::response(503, nlohmann::json{ {"message", "Seat inventory is disabled"} }.dump());
+        }
+
+        return seats_response(flight_number, seat_inventory->close(flight_number));
+
+    } catch (const std::exception& e) {
+        nlohmann::json error = {
+            {"message", "Internal server error"},
+            {"error", e.what()}
+        };
+        return crow::response(500, error.dump());
+    }
+}
+
 // GET /api/v1/flights/{flightNumber}
 crow::response FlightController::get_flight_by_number(const std::string& flight_number) {
     try {
-        auto flight_opt = flight_repository.get_flight_by_number(flight_number);
-        
-        Flight flight = flight_opt.value();
-        auto response_json = flight.to_api_json();
+        std::string body;
+
+        if (flight_catalog) {
+            auto fragment = flight_catalog->get_flight_fragment(flight_number);
+
+            if (!fragment) {
+                throw std::runtime_error("Flight not found: " + flight_number);
+            }
+
+            body = *fragment;
+        }
+        else {
+            body = flight_repository.get_flight_by_number(flight_number).value().to_api_json_fragment();
+        }
         
-        crow::response res(200, response_json.dump());
+        crow::response res(200, body);
         res.set_header("Content-Type", "application/json");
         
         return res;
@@ -112,6 +407,12 @@ void FlightController::router(crow::SimpleApp& app) {
         return this->health_check();
             });
 
+    CROW_ROUTE(app, "/manage/statements")
+        .methods("GET"_method)
+        ([this]() {
+        return this->get_statement_stats();
+            });
+
     // Основной endpoint для получения рейсов
     CROW_ROUTE(app, "/api/v1/flights")
         .methods("GET"_method)
@@ -119,6 +420,45 @@ void FlightController::router(crow::SimpleApp& app) {
         return this->get_flights(req);
             });
 
+    // Поиск по маршруту, датам и цене (регистрируется раньше /flights/<string>)
+    CROW_ROUTE(app, "/api/v1/flights/search")
+        .methods("GET"_method)
+        ([this](const crow::request& req) {
+        return this->search_flights(req);
+            });
+
+    // Загрузка расписания (CSV или NDJSON)
+    CROW_ROUTE(app, "/api/v1/flights/import")
+        .methods("POST"_method)
+        ([this](const crow::request& req) {
+        return this->import_flights(req);
+            });
+
+    // Свободные места и бронирование
+    CROW_ROUTE(app, "/api/v1/flights/<string>/seats")
+        .methods("GET"_method)
+        ([this](const std::string& flight_number) {
+        return this->get_seats(flight_number);
+            });
+
+    CROW_ROUTE(app, "/api/v1/flights/<string>/seats/reserve")
+        .methods("POST"_method)
+        ([this](const crow::request& req, const std::string& flight_number) {
+        return this->change_seats(req, flight_number, true);
+            });
+
+    CROW_ROUTE(app, "/api/v1/flights/<string>/seats/release")
+        .methods("POST"_method)
+        ([this](const crow::request& req, const std::string& flight_number) {
+        return this->change_seats(req, flight_number, false);
+            });
+
+    CROW_ROUTE(app, "/api/v1/flights/<string>/close")
+        .methods("POST"_method)
+        ([this](const std::string& flight_number) {
+        return this->close_flight(flight_number);
+            });
+
     // Endpoint для получения конкретного рейса
     CROW_ROUTE(app, "/api/v1/flights/<string>")
         .methods("GET"_method)
@@ -2,14 +2,27 @@
 #include <crow.h>
 #include <nlohmann/json.hpp>
 #include "../database/FlightRepository.h"
+#include "../catalog/FlightCatalog.h"
+#include "../importer/FlightImporter.h"
+#include "../inventory/SeatInventory.h"
 
 class FlightController {
 private:
     FlightRepository& flight_repository;
+
+    // Каталог в памяти; nullptr - чтение напрямую из БД
+    FlightCatalog* flight_catalog;
+
+    // Учет мест; nullptr - бронирование недоступно
+    SeatInventory* seat_inventory;
     
 public:
-    explicit FlightController(FlightRepository& repo)
+    explicit FlightController(FlightRepository& repo,
+        FlightCatalog* catalog = nullptr,
+        SeatInventory* inventory = nullptr)
         : flight_repository(repo) 
+        , flight_catalog(catalog)
+        , seat_inventory(inventory)
     {}
     
     void router(crow::SimpleApp& app);
@@ -17,7 +30,13 @@ public:
 private:
     crow::response get_flights(const crow::request& req);
     crow::response get_flight_by_number(const std::string& flight_number);
+    crow::response search_flights(const crow::request& req);
+    crow::response import_flights(const crow::request& req);
+    crow::response get_seats(const std::string& flight_number);
+    crow::response change_seats(const crow::request& req, const std::string& flight_number, bool reserve);
+    crow::response close_flight(const std::string& flight_number);
     crow::response health_check();
+    crow::response get_statement_stats();
     
-    nlohmann::json create_pagination_response(const FlightRepository::PaginationResult& result);
+    std::string create_pagination_response(const FlightRepository::PaginationResult& result);
 };
\ No newline at end of file
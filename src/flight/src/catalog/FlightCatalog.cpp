@@ -0,0 +1,416 @@
+#include "FlightCatalog.h"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+FlightCatalog::FlightCatalog(FlightRepository& repo, std::chrono::seconds refresh_interval)
+    : flight_repository(repo)
+    , refresh_interval(refresh_interval) {
+}
+
+FlightCatalog::~FlightCatalog() {
+    stop();
+}
+
+void FlightCatalog::start() {
+    refresh();
+
+    auto loaded = snapshot();
+    std::cout << "Flight catalog: loaded " << loaded->flights.size() << " flights" << std::endl;
+
+    refresher = std::thread([this]() { run(); });
+}
+
+void FlightCatalog::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex);
+        stopping = true;
+    }
+    stop_cv.notify_all();
+
+    if (refresher.joinable()) {
+        refresher.join();
+    }
+}
+
+bool FlightCatalog::is_loaded() const {
+    return snapshot() != nullptr;
+}
+
+std::shared_ptr<const FlightCatalog::Snapshot> FlightCatalog::snapshot() const {
+    return std::atomic_load(&current);
+}
+
+void FlightCatalog::run() {
+    std::unique_lock<std::mutex> lock(stop_mutex);
+
+    while (!stop_cv.wait_for(lock, refresh_interval, [this]() { return stopping; })) {
+        lock.unlock();
+
+        try {
+            refresh();
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Flight catalog: refresh failed, serving previous snapshot: " << e.what() << std::endl;
+        }
+
+        lock.lock();
+    }
+}
+
+void FlightCatalog::refresh() {
+    auto previous = snapshot();
+    std::uint64_t watermark = previous ? previous->watermark : 0;
+
+    auto changes = flight_repository.get_flights_changed_since(watermark);
+
+    // Номер транзакции обернулся через 2^32 - перечитываем таблицу целиком
+    if (previous && changes.watermark < watermark) {
+        changes = flight_repository.get_flights_changed_since(0);
+        previous.reset();
+    }
+
+    if (!previous) {
+        std::atomic_store(&current, std::shared_ptr<const Snapshot>(
+            build_snapshot(to_entries(std::move(changes.flights)), changes.watermark)));
+        return;
+    }
+
+    // Переименованный аэропорт получает новый индекс в словаре, а строки
+    // flight при этом не меняются - индексы переносимых рейсов сверяются
+    // с текущими, рейсы с устаревшими индексами собираются заново.
+    bool airports_changed = false;
+    bool airport_missing = false;
+
+    auto current_airport = [&](const Airport& airport, std::uint32_t& index) {
+        auto it = changes.airports.find(airport.get_id());
+        if (it == changes.airports.end()) {
+            airport_missing = true;
+            return false;
+        }
+        index = it->second;
+        // Записи словаря не перемещаются: разные адреса - разные индексы
+        return &AirportDictionary::instance().get(index) != &airport;
+    };
+
+    std::unordered_map<int, Entry> merged;
+    merged.reserve(previous->flights.size() + changes.flights.size());
+
+    for (std::size_t i = 0; i < previous->flights.size(); ++i) {
+        const Flight& flight = previous->flights[i];
+        std::uint32_t from_index = 0;
+        std::uint32_t to_index = 0;
+
+        bool from_changed = current_airport(flight.get_from_airport(), from_index);
+        bool to_changed = current_airport(flight.get_to_airport(), to_index);
+
+        if (from_changed || to_changed) {
+            airports_changed = true;
+            merged.emplace(flight.get_id(), Entry{
+                Flight(flight.get_id(), flight.get_flight_number(), flight.get_departure(),
+                    from_index, to_index, flight.get_price()),
+                nullptr });
+        }
+        else {
+            merged.emplace(flight.get_id(), Entry{ flight, previous->fragments[i] });
+        }
+    }
+
+    // Аэропорт рейса исчез из справочника - перечитываем таблицу целиком
+    if (airport_missing) {
+        changes = flight_repository.get_flights_changed_since(0);
+        std::atomic_store(&current, std::shared_ptr<const Snapshot>(
+            build_snapshot(to_entries(std::move(changes.flights)), changes.watermark)));
+        return;
+    }
+
+    if (changes.flights.empty() && !airports_changed &&
+        static_cast<std::size_t>(changes.total_count) == previous->flights.size()) {
+        return;
+    }
+
+    // Накладываем изменения на предыдущий снимок по id.
+    // Неизмененные рейсы сохраняют готовые фрагменты, измененные сериализуются заново.
+
+    for (auto& flight : changes.flights) {
+        int id = flight.get_id();
+        merged.insert_or_assign(id, Entry{ std::move(flight), nullptr });
+    }
+
+    // Расхождение в количестве означает удаленные строки - их xmin не отследить
+    if (merged.size() != static_cast<std::size_t>(changes.total_count)) {
+        changes = flight_repository.get_flights_changed_since(0);
+        std::atomic_store(&current, std::shared_ptr<const Snapshot>(
+            build_snapshot(to_entries(std::move(changes.flights)), changes.watermark)));
+        return;
+    }
+
+    std::vector<Entry> entries;
+    entries.reserve(merged.size());
+
+    for (auto& [id, entry] : merged) {
+        entries.push_back(std::move(entry));
+    }
+
+    std::atomic_store(&current, std::shared_ptr<const Snapshot>(
+        build_snapshot(std::move(entries), changes.watermark)));
+}
+
+std::vector<FlightCatalog::Entry> FlightCatalog::to_entries(std::vector<Flight> flights) {
+    std::vector<Entry> entries;
+    entries.reserve(flights.size());
+
+    for (auto& flight : flights) {
+        entries.push_back(Entry{ std::move(flight), nullptr });
+    }
+
+    return entries;
+}
+
+std::shared_ptr<FlightCatalog::Snapshot> FlightCatalog::build_snapshot(std::vector<Entry> entries,
+    std::uint64_t watermark) {
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->watermark = watermark;
+
+    std::sort(entries.begin(), entries.end(),
+        [](const Entry& a, const Entry& b) {
+            if (a.flight.get_departure() != b.flight.get_departure()) {
+                return a.flight.get_departure() < b.flight.get_departure();
+            }
+            return a.flight.get_id() < b.flight.get_id();
+        });
+
+    snapshot->flights.reserve(entries.size());
+    snapshot->fragments.reserve(entries.size());
+
+    for (auto& entry : entries) {
+        if (!entry.fragment) {
+            entry.fragment = std::make_shared<const std::string>(entry.flight.to_api_json_fragment());
+        }
+
+        snapshot->flights.push_back(std::move(entry.flight));
+        snapshot->fragments.push_back(std::move(entry.fragment));
+    }
+
+    snapshot->by_number.reserve(snapshot->flights.size());
+
+    auto index_airport = [&snapshot](const Airport& airport) {
+        for (const std::string& name : { airport.get_city(), airport.get_name(), airport.get_full_name() }) {
+            auto& ids = snapshot->airport_ids_by_name[name];
+            if (std::find(ids.begin(), ids.end(), airport.get_id()) == ids.end()) {
+                ids.push_back(airport.get_id());
+            }
+        }
+    };
+
+    for (std::size_t i = 0; i < snapshot->flights.size(); ++i) {
+        const Flight& flight = snapshot->flights[i];
+        auto [it, inserted] = snapshot->by_number.emplace(std::string(flight.get_flight_number()), i);
+
+        // При дублях номера отдаем рейс с меньшим id
+        if (!inserted && snapshot->flights[it->second].get_id() > flight.get_id()) {
+            it->second = i;
+        }
+
+        auto index = static_cast<std::uint32_t>(i);
+
+        snapshot->by_route[route_key(flight.get_from_airport().get_id(), flight.get_to_airport().get_id())]
+            .push_back(index);
+        snapshot->by_price_bucket[flight.get_price() / price_bucket_width].push_back(index);
+
+        index_airport(flight.get_from_airport());
+        index_airport(flight.get_to_airport());
+    }
+
+    return snapshot;
+}
+
+std::uint64_t FlightCatalog::route_key(int from_airport_id, int to_airport_id) {
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(from_airport_id)) << 32)
+        | static_cast<std::uint32_t>(to_airport_id);
+}
+
+FlightRepository::PaginationResult FlightCatalog::get_flights_paginated(int page, int page_size) const {
+    FlightRepository::PaginationResult result;
+
+    if (page < 1) page = 1;
+    if (page_size < 1) page_size = 10;
+    if (page_size > 100) page_size = 100;
+
+    auto snapshot = this->snapshot();
+
+    result.page = page;
+    result.page_size = page_size;
+    result.total_count = static_cast<int>(snapshot->flights.size());
+
+    std::size_t offset = static_cast<std::size_t>(page - 1) * static_cast<std::size_t>(page_size);
+
+    if (offset < snapshot->flights.size()) {
+        std::size_t end = std::min(offset + static_cast<std::size_t>(page_size), snapshot->flights.size());
+        result.fragments.assign(snapshot->fragments.begin() + offset, snapshot->fragments.begin() + end);
+    }
+
+    return result;
+}
+
+std::shared_ptr<const std::string> FlightCatalog::get_flight_fragment(const std::string& flight_number) const {
+    auto snapshot = this->snapshot();
+
+    auto it = snapshot->by_number.find(flight_number);
+
+    if (it == snapshot->by_number.end()) {
+        return nullptr;
+    }
+
+    return snapshot->fragments[it->second];
+}
+
+
+FlightRepository::PaginationResult FlightCatalog::search(const SearchQuery& query) const {
+    FlightRepository::PaginationResult result;
+
+    result.page = query.page < 1 ? 1 : query.page;
+    result.page_size = query.page_size < 1 ? 10 : std::min(query.page_size, 100);
+    result.total_count = 0;
+
+    auto snapshot = this->snapshot();
+    const auto& flights = snapshot->flights;
+
+    auto resolve_airports = [&snapshot](const std::string& name) -> const std::vector<int>* {
+        auto it = snapshot->airport_ids_by_name.find(name);
+        return it == snapshot->airport_ids_by_name.end() ? nullptr : &it->second;
+    };
+
+    const std::vector<int>* from_ids = nullptr;
+    const std::vector<int>* to_ids = nullptr;
+
+    if (!query.from.empty() && !(from_ids = resolve_airports(query.from))) {
+        return result;
+    }
+
+    if (!query.to.empty() && !(to_ids = resolve_airports(query.to))) {
+        return result;
+    }
+
+    // Границы дат как диапазон индексов отсортированного массива.
+    // Дата без времени в dateTo означает весь день.
+    auto parse_date = [](const std::string& value) {
+        auto parsed = date_time::parse(value);
+        if (!parsed) {
+            throw std::invalid_argument("Invalid date: " + value);
+        }
+        return *parsed;
+    };
+
+    std::size_t lo = 0;
+    std::size_t hi = flights.size();
+
+    if (!query.date_from.empty()) {
+        std::int64_t date_from = parse_date(query.date_from);
+        lo = std::lower_bound(flights.begin(), flights.end(), date_from,
+            [](const Flight& flight, std::int64_t date) { return flight.get_departure() < date; })
+            - flights.begin();
+    }
+
+    if (!query.date_to.empty()) {
+        std::int64_t date_to = parse_date(query.date_to) + (query.date_to.size() == 10 ? 86399 : 0);
+        hi = std::upper_bound(flights.begin(), flights.end(), date_to,
+            [](std::int64_t date, const Flight& flight) { return date < flight.get_departure(); })
+            - flights.begin();
+    }
+
+    if (lo >= hi) {
+        return result;
+    }
+
+    auto matches = [&](const Flight& flight) {
+        if (from_ids && std::find(from_ids->begin(), from_ids->end(), flight.get_from_airport().get_id()) == from_ids->end()) {
+            return false;
+        }
+        if (to_ids && std::find(to_ids->begin(), to_ids->end(), flight.get_to_airport().get_id()) == to_ids->end()) {
+            return false;
+        }
+        if (query.min_price && flight.get_price() < *query.min_price) {
+            return false;
+        }
+        if (query.max_price && flight.get_price() > *query.max_price) {
+            return false;
+        }
+        return true;
+    };
+
+    // Кандидаты берем из самого узкого индекса, остальные условия проверяем фильтром
+    std::vector<std::uint32_t> matched;
+
+    auto collect_range = [&](const std::vector<std::uint32_t>& indexes) {
+        auto begin = std::lower_bound(indexes.begin(), indexes.end(), static_cast<std::uint32_t>(lo));
+        auto end = std::lower_bound(begin, indexes.end(), static_cast<std::uint32_t>(hi));
+
+        for (auto it = begin; it != end; ++it) {
+            if (matches(flights[*it])) {
+                matched.push_back(*it);
+            }
+        }
+    };
+
+    if (from_ids && to_ids) {
+        for (int from_id : *from_ids) {
+            for (int to_id : *to_ids) {
+                auto it = snapshot->by_route.find(route_key(from_id, to_id));
+                if (it != snapshot->by_route.end()) {
+                    collect_range(it->second);
+                }
+            }
+        }
+        std::sort(matched.begin(), matched.end());
+    }
+    else if ((query.min_price || query.max_price) && query.date_from.empty() && query.date_to.empty()) {
+        auto begin = query.min_price
+            ? snapshot->by_price_bucket.lower_bound(*query.min_price / price_bucket_width)
+            : snapshot->by_price_bucket.begin();
+        auto end = query.max_price
+            ? snapshot->by_price_bucket.upper_bound(*query.max_price / price_bucket_width)
+            : snapshot->by_price_bucket.end();
+
+        for (auto it = begin; it != end; ++it) {
+            collect_range(it->second);
+        }
+        std::sort(matched.begin(), matched.end());
+    }
+    else {
+        for (std::size_t i = lo; i < hi; ++i) {
+            if (matches(flights[i])) {
+                matched.push_back(static_cast<std::uint32_t>(i));
+            }
+        }
+    }
+
+    // Индексы уже упорядочены по дате; для остальных сортировок - стабильная пересортировка
+    switch (query.sort) {
+    case SortOrder::DateAsc:
+        break;
+    case SortOrder::DateDesc:
+        std::reverse(matched.begin(), matched.end());
+        break;
+    case SortOrder::PriceAsc:
+        std::stable_sort(matched.begin(), matched.end(), [&flights](std::uint32_t a, std::uint32_t b) {
+            return flights[a].get_price() < flights[b].get_price();
+        });
+        break;
+    case SortOrder::PriceDesc:
+        std::stable_sort(matched.begin(), matched.end(), [&flights](std::uint32_t a, std::uint32_t b) {
+            return flights[a].get_price() > flights[b].get_price();
+        });
+        break;
+    }
+
+    result.total_count = static_cast<int>(matched.size());
+
+    std::size_t offset = static_cast<std::size_t>(result.page - 1) * static_cast<std::size_t>(result.page_size);
+
+    for (std::size_t i = offset; i < matched.size() && i < offset + static_cast<std::size_t>(result.page_size); ++i) {
+        result.fragments.push_back(snapshot->fragments[matched[i]]);
+    }
+
+    return result;
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "../database/FlightRepository.h"
+#include "../models/Flight.h"
+
+// In-memory каталог рейсов.
+// Читатели получают неизменяемый снимок через атомарную загрузку shared_ptr и
+// не берут блокировок. Фоновый поток периодически запрашивает из БД рейсы,
+// измененные с прошлого обновления, собирает новый снимок и публикует его
+// атомарной заменой (RCU). При недоступности БД продолжает отдаваться
+// последний успешно загруженный снимок.
+class FlightCatalog {
+public:
+    // Ширина ценового сегмента индекса по цене
+    static constexpr int price_bucket_width = 500;
+
+    struct Snapshot {
+        // Отсортированы как в БД-выдаче: по дате вылета, затем по id.
+        // Списки индексов ниже возрастают, а значит тоже упорядочены по дате.
+        std::vector<Flight> flights;
+        // JSON-фрагмент ответа API для flights[i]; переносится между снимками,
+        // пока рейс не изменился
+        std::vector<std::shared_ptr<const std::string>> fragments;
+        std::unordered_map<std::string, std::size_t> by_number;
+
+        // (from_airport_id << 32 | to_airport_id) -> рейсы маршрута
+        std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> by_route;
+        // price / price_bucket_width -> рейсы сегмента
+        std::map<int, std::vector<std::uint32_t>> by_price_bucket;
+        // Город, название аэропорта или "город название" -> id аэропортов
+        std::unordered_map<std::string, std::vector<int>> airport_ids_by_name;
+
+        std::uint64_t watermark = 0;
+    };
+
+    enum class SortOrder { DateAsc, DateDesc, PriceAsc, PriceDesc };
+
+    // Параметры поиска; пустые поля не ограничивают выборку.
+    // Даты в формате "YYYY-MM-DD" или "YYYY-MM-DD HH:MM", обе границы включительно.
+    struct SearchQuery {
+        std::string from;
+        std::string to;
+        std::string date_from;
+        std::string date_to;
+        std::optional<int> min_price;
+        std::optional<int> max_price;
+        SortOrder sort = SortOrder::DateAsc;
+        int page = 1;
+        int page_size = 10;
+    };
+
+    FlightCatalog(FlightRepository& repo, std::chrono::seconds refresh_interval);
+    ~FlightCatalog();
+
+    FlightCatalog(const FlightCatalog&) = delete;
+    FlightCatalog& operator=(const FlightCatalog&) = delete;
+
+    // Первичная загрузка (бросает исключение при ошибке) и запуск фонового обновления
+    void start();
+    void stop();
+
+    bool is_loaded() const;
+
+    std::shared_ptr<const Snapshot> snapshot() const;
+
+    FlightRepository::PaginationResult get_flights_paginated(int page, int page_size) const;
+    std::shared_ptr<const std::string> get_flight_fragment(const std::string& flight_number) const;
+
+    FlightRepository::PaginationResult search(const SearchQuery& query) const;
+
+private:
+    static std::uint64_t route_key(int from_airport_id, int to_airport_id);
+
+    void refresh();
+    void run();
+
+    // Рейс и его фрагмент (nullptr - сериализовать заново)
+    struct Entry {
+        Flight flight;
+        std::shared_ptr<const std::string> fragment;
+    };
+
+    static std::shared_ptr<Snapshot> build_snapshot(std::vector<Entry> entries, std::uint64_t watermark);
+    static std::vector<Entry> to_entries(std::vector<Flight> flights);
+
+    FlightRepository& flight_repository;
+    std::chrono::seconds refresh_interval;
+
+    // Доступ только через std::atomic_load / std::atomic_store
+    std::shared_ptr<const Snapshot> current;
+
+    std::thread refresher;
+    std::mutex stop_mutex;
+    std::condition_variable stop_cv;
+    bool stopping = false;
+};
@@ -1,87 +1,77 @@
 #include "FlightRepository.h"
 #include <stdexcept>
 #include <iostream>
+#include <unordered_map>
+
+FlightRepository::FlightRepository(const std::string& connection_string, std::size_t pool_size) {
+    // Схема создается миграциями (см. Migrations) до создания репозитория
+    register_statements();
 
-FlightRepository::FlightRepository(const std::string& connection_string) {
     try {
-        connection = std::make_unique<pqxx::connection>(connection_string);
+        pool = std::make_unique<ConnectionPool>(connection_string, pool_size,
+            [this](pqxx::connection& conn) { statements.prepare(conn); });
         std::cout << "Connected to database successfully!" << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "Database connection failed: " << e.what() << std::endl;
         throw;
     }
+}
 
+FlightRepository::~FlightRepository() {
+}
 
-    try {
-        pqxx::work txn(*connection);
+void FlightRepository::register_statements() {
+    statements.add("get_airport_by_id",
+        "SELECT id, name, city, country FROM airport WHERE id = $1");
 
-        std::string sql = "";
-
-        auto result = txn.exec("SELECT count(*) FROM information_schema.tables WHERE table_schema = 'public'");
-        sql.clear();
-
-        if (result[0][0].as<int>() == 0) {
-            sql.clear();
-            sql = "CREATE TABLE airport\
-                (\
-                    id      SERIAL PRIMARY KEY,\
-                    name    VARCHAR(255),\
-                    city    VARCHAR(255),\
-                    country VARCHAR(255)\
-                    );";
-            result = txn.exec(sql);
-            
-            sql.clear();
-            sql = "CREATE TABLE flight\
-                (\
-                    id              SERIAL PRIMARY KEY,\
-                    flight_number   VARCHAR(20)              NOT NULL,\
-                    datetime        TIMESTAMP WITH TIME ZONE NOT NULL,\
-                    from_airport_id INT REFERENCES airport(id),\
-                    to_airport_id   INT REFERENCES airport(id),\
-                    price           INT                      NOT NULL\
-                    );";
-            result = txn.exec(sql);
-
-
-            sql = "INSERT INTO airport (id, name, city, country) VALUES\
-            (1, 'Шереметьево', 'Москва', 'Россия'),\
-            (2, 'Пулково', 'Санкт-Петербург', 'Россия');";
-            result = txn.exec(sql);
-
-            sql.clear();
-            sql = "INSERT INTO flight (id, flight_number, datetime, from_airport_id, to_airport_id, price) VALUES\
-            (1, 'AFL031', '2021-10-08 20:00:00', 2, 1, 1500); ";
-            result = txn.exec(sql);
+    statements.add("get_all_flights",
+        "SELECT id, flight_number, datetime, from_airport_id, to_airport_id, price FROM flight ORDER BY datetime ASC LIMIT $1 OFFSET $2");
 
-        }
+    statements.add("get_flight_by_number",
+        "SELECT id, flight_number, datetime, from_airport_id, to_airport_id, price FROM flight WHERE flight_number = $1");
 
-        txn.commit();
-    }
-    catch (const std::exception& e) {
-        std::cerr << "Create table database and test data error: " << e.what() << std::endl;
-    }
-}
+    statements.add("get_total_flights_count",
+        "SELECT COUNT(*) as count FROM flight");
 
-FlightRepository::~FlightRepository() {
+    statements.add("get_all_airports",
+        "SELECT id, name, city, country FROM airport");
+
+    statements.add("get_seat_counts",
+        "SELECT id, seats_total, seats_remaining, closed FROM flight WHERE flight_number = $1 ORDER BY id LIMIT 1");
+
+    statements.add("close_flight",
+        "UPDATE flight SET closed = true WHERE id = $1");
+
+    statements.add("apply_seat_deltas", R"(
+            UPDATE flight AS f
+            SET seats_remaining = LEAST(f.seats_total, GREATEST(0, f.seats_remaining + d.delta))
+            FROM unnest($1::int[], $2::int[]) AS d(id, delta)
+            WHERE f.id = d.id
+        )");
+
+    // Нижняя граница незавершенных транзакций: все строки с меньшим xmin уже видны
+    statements.add("get_snapshot_watermark",
+        "SELECT txid_snapshot_xmin(txid_current_snapshot()) % 4294967296 AS watermark");
+
+    statements.add("get_flights_changed_since",
+        "SELECT id, flight_number, datetime, from_airport_id, to_airport_id, price FROM flight WHERE xmin::text::bigint >= $1");
 }
 
 bool FlightRepository::connect() {
-    return connection && connection->is_open();
+    return pool && pool->is_connected();
 }
 
 bool FlightRepository::is_connected() const {
-    return connection && connection->is_open();
+    return pool && pool->is_connected();
 }
 
-Airport FlightRepository::get_airport_by_id(int id) {
-    try {
-        pqxx::work txn(*connection);
+std::vector<std::pair<std::string, std::uint64_t>> FlightRepository::get_statement_stats() const {
+    return statements.get_execution_counts();
+}
 
-        auto result = txn.exec(
-            "SELECT id, name, city, country FROM airport WHERE id = $1",
-            pqxx::params{ id }
-        );
+Airport FlightRepository::get_airport_by_id(pqxx::transaction_base& txn, int id) {
+    try {
+        auto result = statements.exec(txn, "get_airport_by_id", pqxx::params{ id });
         
         if (result.empty()) {
             throw std::runtime_error("Airport not found with id: " + std::to_string(id));
@@ -100,33 +90,242 @@ Airport FlightRepository::get_airport_by_id(int id) {
     }
 }
 
-std::string FlightRepository::parse_timestamp(const std::string& timestamp_str) {
-    std::string datetime = timestamp_str.substr(0, 16);
-    return datetime;
+std::int64_t FlightRepository::parse_timestamp(std::string_view timestamp_str) {
+    auto datetime = date_time::parse(timestamp_str);
+
+    if (!datetime) {
+        throw std::runtime_error("Invalid flight timestamp: " + std::string(timestamp_str));
+    }
+
+    return *datetime;
 }
 
-Flight FlightRepository::create_flight_from_row(const pqxx::row& row) {
+Flight FlightRepository::create_flight_from_row(pqxx::transaction_base& txn, const pqxx::row& row) {
     try {
-        int id = row["id"].as<int>();
-        std::string flight_number = row["flight_number"].as<std::string>();
-        std::string datetime_str = row["datetime"].as<std::string>();
-        int from_airport_id = row["from_airport_id"].as<int>();
-        int to_airport_id = row["to_airport_id"].as<int>();
-        int price = row["price"].as<int>();
-        
+        auto& dictionary = AirportDictionary::instance();
 
-        Airport from_airport = get_airport_by_id(from_airport_id);
-        Airport to_airport = get_airport_by_id(to_airport_id);
-        
-        std::string datetime = parse_timestamp(datetime_str);
-        
-        return Flight(id, flight_number, datetime, from_airport, to_airport, price);
+        std::uint32_t from_airport = dictionary.intern(get_airport_by_id(txn, row["from_airport_id"].as<int>()));
+        std::uint32_t to_airport = dictionary.intern(get_airport_by_id(txn, row["to_airport_id"].as<int>()));
+
+        return create_flight_from_row(row, from_airport, to_airport);
     } catch (const std::exception& e) {
         std::cerr << "Error creating flight from row: " << e.what() << std::endl;
         throw;
     }
 }
 
+Flight FlightRepository::create_flight_from_row(const pqxx::row& row,
+    std::uint32_t from_airport, std::uint32_t to_airport) {
+    int id = row["id"].as<int>();
+    int price = row["price"].as<int>();
+
+    std::int64_t datetime = parse_timestamp(row["datetime"].view());
+
+    return Flight(id, row["flight_number"].view(), datetime, from_airport, to_airport, price);
+}
+
+FlightRepository::FlightChanges FlightRepository::get_flights_changed_since(std::uint64_t watermark) {
+    FlightChanges changes;
+
+    try {
+        if (!is_connected()) {
+            throw std::runtime_error("Database not connected");
+        }
+
+        auto connection = pool->acquire();
+
+        // Один снимок для watermark, изменений и общего количества рейсов
+        pqxx::transaction<pqxx::isolation_level::repeatable_read> txn(*connection);
+
+        changes.watermark = statements.exec(txn, "get_snapshot_watermark")[0]["watermark"].as<std::uint64_t>();
+
+        // id аэропорта -> индекс в AirportDictionary
+        std::unordered_map<int, std::uint32_t> airports;
+        for (const auto& row : statements.exec(txn, "get_all_airports")) {
+            int id = row["id"].as<int>();
+            airports.emplace(id, AirportDictionary::instance().intern(Airport(
+                id,
+                row["name"].as<std::string>(),
+                row["city"].as<std::string>(),
+                row["country"].as<std::string>()
+            )));
+        }
+
+        auto result = statements.exec(txn, "get_flights_changed_since",
+            pqxx::params{ static_cast<long long>(watermark) });
+
+        changes.flights.reserve(result.size());
+
+        for (const auto& row : result) {
+            auto from_it = airports.find(row["from_airport_id"].as<int>());
+            auto to_it = airports.find(row["to_airport_id"].as<int>());
+
+            if (from_it == airports.end() || to_it == airports.end()) {
+                throw std::runtime_error("Airport not found for flight id: " + row["id"].as<std::string>());
+            }
+
+            changes.flights.push_back(create_flight_from_row(row, from_it->second, to_it->second));
+        }
+
+        changes.total_count = statements.exec(txn, "get_total_flights_count")[0]["count"].as<int>();
+        changes.airports = std::move(airports);
+
+        txn.commit();
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error getting changed flights: " << e.what() << std::endl;
+        throw;
+    }
+
+    return changes;
+}
+
+std::vector<Airport> FlightRepository::get_all_airports() {
+    std::vector<Airport> airports;
+
+    try {
+        if (!is_connected()) {
+            throw std::runtime_error("Database not connected");
+        }
+
+        auto connection = pool->acquire();
+        pqxx::work txn(*connection);
+
+        auto result = statements.exec(txn, "get_all_airports");
+        txn.commit();
+
+        airports.reserve(result.size());
+
+        for (const auto& row : result) {
+            airports.emplace_back(
+                row["id"].as<int>(),
+                row["name"].as<std::string>(),
+                row["city"].as<std::string>(),
+                row["country"].as<std::string>()
+            );
+        }
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error getting airports: " << e.what() << std::endl;
+        throw;
+    }
+
+    return airports;
+}
+
+void FlightRepository::copy_flights(const std::vector<FlightImportRow>& rows) {
+    if (rows.empty()) {
+        return;
+    }
+
+    try {
+        if (!is_connected()) {
+            throw std::runtime_error("Database not connected");
+        }
+
+        auto connection = pool->acquire();
+        pqxx::work txn(*connection);
+
+        auto stream = pqxx::stream_to::table(txn, { "flight" },
+            { "flight_number", "datetime", "from_airport_id", "to_airport_id", "price" });
+
+        std::string datetime;
+
+        for (const auto& row : rows) {
+            datetime.clear();
+            date_time::append(datetime, row.departure);
+
+            stream.write_values(row.flight_number, datetime, row.from_airport_id, row.to_airport_id, row.price);
+        }
+
+        stream.complete();
+        txn.commit();
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error copying flights: " << e.what() << std::endl;
+        throw;
+    }
+}
+
+std::optional<FlightRepository::SeatCounts> FlightRepository::get_seat_counts(const std::string& flight_number) {
+    try {
+        if (!is_connected()) {
+            throw std::runtime_error("Database not connected");
+        }
+
+        auto connection = pool->acquire();
+        pqxx::work txn(*connection);
+
+        auto result = statements.exec(txn, "get_seat_counts", pqxx::params{ flight_number });
+        txn.commit();
+
+        if (result.empty()) {
+            return std::nullopt;
+        }
+
+        return SeatCounts{
+            result[0]["id"].as<int>(),
+            result[0]["seats_total"].as<int>(),
+            result[0]["seats_remaining"].as<int>(),
+            result[0]["closed"].as<bool>()
+        };
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error getting seat counts: " << e.what() << std::endl;
+        throw;
+    }
+}
+
+void FlightRepository::close_flight(int flight_id) {
+    try {
+        if (!is_connected()) {
+            throw std::runtime_error("Database not connected");
+        }
+
+        auto connection = pool->acquire();
+        pqxx::work txn(*connection);
+
+        statements.exec(txn, "close_flight", pqxx::params{ flight_id });
+        txn.commit();
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error closing flight: " << e.what() << std::endl;
+        throw;
+    }
+}
+
+void FlightRepository::apply_seat_deltas(const std::vector<std::pair<int, int>>& deltas) {
+    if (deltas.empty()) {
+        return;
+    }
+
+    try {
+        if (!is_connected()) {
+            throw std::runtime_error("Database not connected");
+        }
+
+        std::vector<int> ids;
+        std::vector<int> values;
+        ids.reserve(deltas.size());
+        values.reserve(deltas.size());
+
+        for (const auto& [id, delta] : deltas) {
+            ids.push_back(id);
+            values.push_back(delta);
+        }
+
+        auto connection = pool->acquire();
+        pqxx::work txn(*connection);
+
+        statements.exec(txn, "apply_seat_deltas", pqxx::params{ ids, values });
+        txn.commit();
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error applying seat deltas: " << e.what() << std::endl;
+        throw;
+    }
+}
+
 std::vector<Flight> FlightRepository::get_all_flights(int page, int page_size) {
     std::vector<Flight> flights;
     
@@ -135,19 +334,19 @@ std::vector<Flight> FlightRepository::get_all_flights(int page, int page_size) {
             throw std::runtime_error("Database not connected");
         }
         
+        auto connection = pool->acquire();
         pqxx::work txn(*connection);
 
         int offset = (page - 1) * page_size;
         
-        std::string sql = "SELECT id, flight_number, datetime, from_airport_id, to_airport_id, price FROM flight ORDER BY datetime ASC LIMIT $1 OFFSET $2";
-        
-        auto result = txn.exec(sql,
+        auto result = statements.exec(txn, "get_all_flights",
             pqxx::params{ page_size, offset });
-        txn.commit();
         
         for (const auto& row : result) {
-            flights.push_back(create_flight_from_row(row));
+            flights.push_back(create_flight_from_row(txn, row));
         }
+
+        txn.commit();
         
     } catch (const std::exception& e) {
         std::cerr << "Error getting all flights: " << e.what() << std::endl;
@@ -163,19 +362,18 @@ std::optional<Flight> FlightRepository::get_flight_by_number(const std::string&
             throw std::runtime_error("Database not connected");
         }
         
+        auto connection = pool->acquire();
         pqxx::work txn(*connection);
         
-        std::string sql = "SELECT id, flight_number, datetime, from_airport_id, to_airport_id, price FROM flight WHERE flight_number = $1";
-        
-        auto result = txn.exec(sql, 
+        auto result = statements.exec(txn, "get_flight_by_number",
             pqxx::params{ flight_number });
-        txn.commit();
         
         if (result.empty()) {
             return std::nullopt;
         }
 
-        Flight flight = create_flight_from_row(result[0]);
+        Flight flight = create_flight_from_row(txn, result[0]);
+        txn.commit();
          
         return flight;
         
@@ -191,10 +389,10 @@ int FlightRepository::get_total_flights_count() {
             throw std::runtime_error("Database not connected");
         }
         
+        auto connection = pool->acquire();
         pqxx::work txn(*connection);
         
-        std::string sql = "SELECT COUNT(*) as count FROM flight";
-        auto result = txn.exec(sql);
+        auto result = statements.exec(txn, "get_total_flights_count");
         
         if (result.empty()) {
             return 0;
@@ -2,19 +2,28 @@
 #include <memory>
 #include <vector>
 #include <optional>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
 #include <pqxx/pqxx>
+#include "ConnectionPool.h"
+#include "StatementRegistry.h"
 #include "../models/Flight.h"
 
 class FlightRepository {
 private:
-    std::unique_ptr<pqxx::connection> connection;
+    StatementRegistry statements;
+    std::unique_ptr<ConnectionPool> pool;
     
 public:
-    FlightRepository(const std::string& connection_string);
+    FlightRepository(const std::string& connection_string, std::size_t pool_size = 8);
     ~FlightRepository();
     
     bool connect();
     bool is_connected() const;
+
+    // Количество выполнений каждого prepared statement
+    std::vector<std::pair<std::string, std::uint64_t>> get_statement_stats() const;
     
     // /api/v1/flights
     std::vector<Flight> get_all_flights(int page = 1, int page_size = 10);
@@ -26,17 +35,65 @@ public:
     
     struct PaginationResult {
         std::vector<Flight> flights;
+        // Готовые JSON-фрагменты рейсов страницы (заполняет каталог вместо flights)
+        std::vector<std::shared_ptr<const std::string>> fragments;
         int total_count;
         int page;
         int page_size;
     };
     
     PaginationResult get_flights_paginated(int page = 1, int page_size = 10);
+
+    // Изменения таблицы flight для инкрементального обновления каталога
+    struct FlightChanges {
+        std::vector<Flight> flights;
+        int total_count = 0;
+        std::uint64_t watermark = 0;
+        // id аэропорта -> текущий индекс в AirportDictionary (все аэропорты).
+        // Изменение аэропорта не трогает строки flight - индексы
+        // неизмененных рейсов сверяются с этой таблицей.
+        std::unordered_map<int, std::uint32_t> airports;
+    };
+
+    // Рейсы, измененные транзакциями начиная с watermark (0 - все рейсы)
+    FlightChanges get_flights_changed_since(std::uint64_t watermark);
+
+    std::vector<Airport> get_all_airports();
+
+    // Строка импорта расписания с уже проверенными полями
+    struct FlightImportRow {
+        std::string flight_number;
+        std::int64_t departure;
+        int from_airport_id;
+        int to_airport_id;
+        int price;
+    };
+
+    // Пачка рейсов через COPY в одной транзакции
+    void copy_flights(const std::vector<FlightImportRow>& rows);
+
+    struct SeatCounts {
+        int flight_id;
+        int total;
+        int remaining;
+        bool closed;
+    };
+
+    std::optional<SeatCounts> get_seat_counts(const std::string& flight_number);
+
+    // Закрывает рейс для продажи
+    void close_flight(int flight_id);
+
+    // Изменения остатка мест: (id рейса, delta) одним UPDATE
+    void apply_seat_deltas(const std::vector<std::pair<int, int>>& deltas);
     
 private:
-    Airport get_airport_by_id(int id);
+    void register_statements();
+
+    Airport get_airport_by_id(pqxx::transaction_base& txn, int id);
     
-    std::string parse_timestamp(const std::string& timestamp_str);
+    std::int64_t parse_timestamp(std::string_view timestamp_str);
     
-    Flight create_flight_from_row(const pqxx::row& row);
+    Flight create_flight_from_row(pqxx::transaction_base& txn, const pqxx::row& row);
+    Flight create_flight_from_row(const pqxx::row& row, std::uint32_t from_airport, std::uint32_t to_airport);
 };
\ No newline at end of file
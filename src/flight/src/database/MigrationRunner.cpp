@@ -0,0 +1,71 @@
+#include "MigrationRunner.h"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <pqxx/pqxx>
+
+namespace {
+    // Ключ advisory-блокировки миграций (один на базу данных)
+    constexpr long long migration_lock_key = 7316202601;
+}
+
+MigrationRunner::MigrationRunner(const std::string& connection_string, std::vector<Migration> migrations)
+    : connection_string(connection_string)
+    , migrations(std::move(migrations)) {
+
+    std::sort(this->migrations.begin(), this->migrations.end(),
+        [](const Migration& a, const Migration& b) { return a.version < b.version; });
+}
+
+int MigrationRunner::run() {
+    int applied = 0;
+
+    try {
+        pqxx::connection connection(connection_string);
+
+        {
+            pqxx::work txn(connection);
+            txn.exec("SELECT pg_advisory_xact_lock(" + std::to_string(migration_lock_key) + ")");
+            txn.exec(R"(
+                CREATE TABLE IF NOT EXISTS schema_migrations
+                (
+                    version     INT PRIMARY KEY,
+                    description VARCHAR(255) NOT NULL,
+                    applied_at  TIMESTAMP WITH TIME ZONE NOT NULL DEFAULT now()
+                )
+            )");
+            txn.commit();
+        }
+
+        for (const auto& migration : migrations) {
+            pqxx::work txn(connection);
+
+            txn.exec("SELECT pg_advisory_xact_lock(" + std::to_string(migration_lock_key) + ")");
+
+            auto existing = txn.exec("SELECT 1 FROM schema_migrations WHERE version = $1",
+                pqxx::params{ migration.version });
+
+            if (!existing.empty()) {
+                continue;
+            }
+
+            for (const auto& statement : migration.statements) {
+                txn.exec(statement);
+            }
+
+            txn.exec("INSERT INTO schema_migrations (version, description) VALUES ($1, $2)",
+                pqxx::params{ migration.version, migration.description });
+
+            txn.commit();
+            ++applied;
+
+            std::cout << "Migration " << migration.version << " applied: " << migration.description << std::endl;
+        }
+
+    } catch (const std::exception& e) {
+        std::cerr << "Migration failed: " << e.what() << std::endl;
+        throw;
+    }
+
+    return applied;
+}
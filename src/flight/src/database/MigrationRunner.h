@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Версионированная миграция схемы. Все statements одной миграции
+// выполняются в одной транзакции вместе с записью версии.
+struct Migration {
+    int version;
+    std::string description;
+    std::vector<std::string> statements;
+};
+
+// Применяет миграции по возрастанию версии и записывает примененные
+// версии в таблицу schema_migrations. Несколько экземпляров сервиса,
+// стартующих одновременно, сериализуются advisory-блокировкой.
+class MigrationRunner {
+public:
+    MigrationRunner(const std::string& connection_string, std::vector<Migration> migrations);
+
+    // Возвращает количество примененных миграций
+    int run();
+
+private:
+    std::string connection_string;
+    std::vector<Migration> migrations;
+};
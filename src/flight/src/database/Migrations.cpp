@@ -0,0 +1,69 @@
+#include "Migrations.h"
+
+std::vector<Migration> flight_migrations() {
+    return {
+        { 1, "create airport and flight tables", {
+            R"(
+                CREATE TABLE IF NOT EXISTS airport
+                (
+                    id      SERIAL PRIMARY KEY,
+                    name    VARCHAR(255),
+                    city    VARCHAR(255),
+                    country VARCHAR(255)
+                )
+            )",
+            R"(
+                CREATE TABLE IF NOT EXISTS flight
+                (
+                    id              SERIAL PRIMARY KEY,
+                    flight_number   VARCHAR(20)              NOT NULL,
+                    datetime        TIMESTAMP WITH TIME ZONE NOT NULL,
+                    from_airport_id INT REFERENCES airport(id),
+                    to_airport_id   INT REFERENCES airport(id),
+                    price           INT                      NOT NULL
+                )
+            )",
+            // Тестовые данные - только в пустую базу
+            R"(
+                INSERT INTO airport (id, name, city, country)
+                SELECT v.id, v.name, v.city, v.country
+                FROM (VALUES
+                    (1, 'Шереметьево', 'Москва', 'Россия'),
+                    (2, 'Пулково', 'Санкт-Петербург', 'Россия')
+                ) AS v(id, name, city, country)
+                WHERE NOT EXISTS (SELECT 1 FROM airport)
+            )",
+            R"(
+                INSERT INTO flight (id, flight_number, datetime, from_airport_id, to_airport_id, price)
+                SELECT 1, 'AFL031', '2021-10-08 20:00:00', 2, 1, 1500
+                WHERE NOT EXISTS (SELECT 1 FROM flight)
+            )",
+            // Тестовые данные вставлены с явными id - сдвигаем последовательности
+            "SELECT setval(pg_get_serial_sequence('airport', 'id'), COALESCE(MAX(id), 1)) FROM airport",
+            "SELECT setval(pg_get_serial_sequence('flight', 'id'), COALESCE(MAX(id), 1)) FROM flight"
+        } },
+        { 2, "add flight lookup and ordering indexes", {
+            // get_flight_by_number
+            "CREATE INDEX IF NOT EXISTS idx_flight_flight_number ON flight (flight_number)",
+            // get_all_flights: ORDER BY datetime с LIMIT/OFFSET
+            "CREATE INDEX IF NOT EXISTS idx_flight_datetime ON flight (datetime, id)"
+        } },
+        { 3, "add flight seat capacity", {
+            // Константный DEFAULT не переписывает таблицу
+            R"(
+                ALTER TABLE flight
+                    ADD COLUMN IF NOT EXISTS seats_total     INT NOT NULL DEFAULT 100,
+                    ADD COLUMN IF NOT EXISTS seats_remaining INT NOT NULL DEFAULT 100
+            )",
+            R"(
+                ALTER TABLE flight
+                    ADD CONSTRAINT flight_seats_check
+                    CHECK (seats_remaining >= 0 AND seats_remaining <= seats_total)
+            )"
+        } },
+        { 4, "add flight sales closing", {
+            // Закрытый рейс (отменяется) не продается
+            "ALTER TABLE flight ADD COLUMN IF NOT EXISTS closed BOOLEAN NOT NULL DEFAULT false"
+        } }
+    };
+}
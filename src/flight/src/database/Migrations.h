@@ -0,0 +1,6 @@
+#pragma once
+#include <vector>
+#include "MigrationRunner.h"
+
+// Миграции схемы базы данных flights по возрастанию версии
+std::vector<Migration> flight_migrations();
@@ -0,0 +1,44 @@
+#include "StatementRegistry.h"
+#include <algorithm>
+#include <stdexcept>
+
+void StatementRegistry::add(const std::string& name, const std::string& sql) {
+    auto statement = std::make_unique<Statement>();
+    statement->sql = sql;
+
+    if (!statements.emplace(name, std::move(statement)).second) {
+        throw std::logic_error("Statement already registered: " + name);
+    }
+}
+
+void StatementRegistry::prepare(pqxx::connection& connection) const {
+    for (const auto& [name, statement] : statements) {
+        connection.prepare(name, statement->sql);
+    }
+}
+
+pqxx::result StatementRegistry::exec(pqxx::transaction_base& txn, const std::string& name,
+    const pqxx::params& params) {
+    auto it = statements.find(name);
+
+    if (it == statements.end()) {
+        throw std::logic_error("Unknown prepared statement: " + name);
+    }
+
+    it->second->executions.fetch_add(1, std::memory_order_relaxed);
+
+    return txn.exec(pqxx::prepped{ name }, params);
+}
+
+std::vector<std::pair<std::string, std::uint64_t>> StatementRegistry::get_execution_counts() const {
+    std::vector<std::pair<std::string, std::uint64_t>> counts;
+    counts.reserve(statements.size());
+
+    for (const auto& [name, statement] : statements) {
+        counts.emplace_back(name, statement->executions.load(std::memory_order_relaxed));
+    }
+
+    std::sort(counts.begin(), counts.end());
+
+    return counts;
+}
@@ -0,0 +1,289 @@
+#include "FlightImporter.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include "../models/AirportDictionary.h"
+#include "../utils/DateTime.h"
+
+namespace {
+    const std::array<const char*, 5> columns = { "flightNumber", "date", "fromAirport", "toAirport", "price" };
+
+    bool ends_with(std::string_view text, std::string_view suffix) {
+        return text.size() >= suffix.size() && text.substr(text.size() - suffix.size()) == suffix;
+    }
+
+    bool is_blank(const std::string& line) {
+        return std::all_of(line.begin(), line.end(), [](unsigned char c) { return std::isspace(c); });
+    }
+
+    // Поле NDJSON как строка: числа допускаются для id аэропорта и цены
+    std::string field_text(const nlohmann::json& object, const char* key) {
+        auto it = object.find(key);
+
+        if (it == object.end() || it->is_null()) {
+            return "";
+        }
+        if (it->is_string()) {
+            return it->get<std::string>();
+        }
+        if (it->is_number_integer()) {
+            return std::to_string(it->get<long long>());
+        }
+
+        throw std::invalid_argument(std::string("Invalid value of ") + key);
+    }
+}
+
+double FlightImporter::Report::rows_per_second() const {
+    return seconds > 0 ? static_cast<double>(rows_imported) / seconds : 0.0;
+}
+
+nlohmann::json FlightImporter::Report::to_json() const {
+    return {
+        {"rowsRead", rows_read},
+        {"rowsImported", rows_imported},
+        {"rowsRejected", rows_rejected},
+        {"seconds", seconds},
+        {"rowsPerSecond", rows_per_second()},
+        {"errors", errors}
+    };
+}
+
+FlightImporter::FlightImporter(FlightRepository& repo, std::size_t batch_size)
+    : flight_repository(repo)
+    , batch_size(batch_size > 0 ? batch_size : 10000) {
+}
+
+std::optional<FlightImporter::Format> FlightImporter::parse_format(std::string_view name) {
+    if (name == "csv" || ends_with(name, ".csv")) {
+        return Format::Csv;
+    }
+    if (name == "ndjson" || name == "jsonl" || ends_with(name, ".ndjson") || ends_with(name, ".jsonl")) {
+        return Format::Ndjson;
+    }
+    return std::nullopt;
+}
+
+void FlightImporter::load_airports() {
+    airport_ids.clear();
+    airport_by_name.clear();
+
+    auto& dictionary = AirportDictionary::instance();
+
+    for (const auto& airport : flight_repository.get_all_airports()) {
+        airport_ids.insert(airport.get_id());
+        dictionary.intern(airport);
+    }
+}
+
+int FlightImporter::resolve_airport(const std::string& value) {
+    if (value.empty()) {
+        throw std::invalid_argument("Airport is empty");
+    }
+
+    int id = 0;
+    auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), id);
+
+    if (ec == std::errc() && end == value.data() + value.size()) {
+        if (airport_ids.count(id) == 0) {
+            throw std::invalid_argument("Unknown airport id: " + value);
+        }
+        return id;
+    }
+
+    auto cached = airport_by_name.find(value);
+    if (cached != airport_by_name.end()) {
+        return cached->second;
+    }
+
+    auto& dictionary = AirportDictionary::instance();
+    std::unordered_set<int> matches;
+
+    for (std::uint32_t index : dictionary.find_by_name(value)) {
+        int match_id = dictionary.get(index).get_id();
+        if (airport_ids.count(match_id) != 0) {
+            matches.insert(match_id);
+        }
+    }
+
+    if (matches.empty()) {
+        throw std::invalid_argument("Unknown airport: " + value);
+    }
+    if (matches.size() > 1) {
+        throw std::invalid_argument("Ambiguous airport: " + value);
+    }
+
+    id = *matches.begin();
+    airport_by_name.emplace(value, id);
+    return id;
+}
+
+FlightRepository::FlightImportRow FlightImporter::make_row(const std::string& flight_number,
+    const std::string& date,
+    const std::string& from_airport,
+    const std::string& to_airport,
+    const std::string& price) {
+
+    if (flight_number.empty() || flight_number.size() > 20) {
+        throw std::invalid_argument("Invalid flightNumber: " + flight_number);
+    }
+
+    auto departure = date_time::parse_exact(date);
+    if (!departure) {
+        throw std::invalid_argument("Invalid date (expected YYYY-MM-DD HH:MM without time zone): " + date);
+    }
+
+    int price_value = 0;
+    auto [end, ec] = std::from_chars(price.data(), price.data() + price.size(), price_value);
+    if (ec != std::errc() || end != price.data() + price.size() || price_value <= 0) {
+        throw std::invalid_argument("Invalid price: " + price);
+    }
+
+    int from_id = resolve_airport(from_airport);
+    int to_id = resolve_airport(to_airport);
+
+    if (from_id == to_id) {
+        throw std::invalid_argument("fromAirport and toAirport are the same");
+    }
+
+    return { flight_number, *departure, from_id, to_id, price_value };
+}
+
+// Поля через запятую, кавычки экранируются удвоением.
+// Переводы строк внутри полей не поддерживаются.
+std::vector<std::string> FlightImporter::split_csv_line(const std::string& line) {
+    std::vector<std::string> fields(1);
+    bool quoted = false;
+
+    for (std::size_t i = 0; i < line.size(); ++i) {
+        char c = line[i];
+
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                fields.back().push_back('"');
+                ++i;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                fields.back().push_back(c);
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.emplace_back();
+        } else if (c != '\r') {
+            fields.back().push_back(c);
+        }
+    }
+
+    if (quoted) {
+        throw std::invalid_argument("Unterminated quoted field");
+    }
+
+    return fields;
+}
+
+FlightImporter::Report FlightImporter::import(std::istream& input, Format format) {
+    Report report;
+    auto started = std::chrono::steady_clock::now();
+
+    load_airports();
+
+    std::vector<FlightRepository::FlightImportRow> batch;
+    batch.reserve(batch_size);
+
+    auto flush = [&]() {
+        flight_repository.copy_flights(batch);
+        report.rows_imported += batch.size();
+        batch.clear();
+    };
+
+    auto reject = [&](std::size_t line_number, const std::string& message) {
+        ++report.rows_rejected;
+        if (report.errors.size() < max_reported_errors) {
+            report.errors.push_back("line " + std::to_string(line_number) + ": " + message);
+        }
+    };
+
+    // CSV: позиции колонок из строки заголовка
+    std::array<std::size_t, columns.size()> positions{};
+    bool header_read = format != Format::Csv;
+
+    std::string line;
+    std::size_t line_number = 0;
+
+    while (std::getline(input, line)) {
+        ++line_number;
+
+        if (is_blank(line)) {
+            continue;
+        }
+
+        if (!header_read) {
+            auto header = split_csv_line(line);
+
+            for (std::size_t i = 0; i < columns.size(); ++i) {
+                auto it = std::find(header.begin(), header.end(), columns[i]);
+                if (it == header.end()) {
+                    throw std::invalid_argument(std::string("CSV header has no column ") + columns[i]);
+                }
+                positions[i] = static_cast<std::size_t>(it - header.begin());
+            }
+
+            header_read = true;
+            continue;
+        }
+
+        ++report.rows_read;
+
+        try {
+            if (format == Format::Csv) {
+                auto fields = split_csv_line(line);
+
+                for (std::size_t position : positions) {
+                    if (position >= fields.size()) {
+                        throw std::invalid_argument("Not enough columns");
+                    }
+                }
+
+                batch.push_back(make_row(fields[positions[0]], fields[positions[1]],
+                    fields[positions[2]], fields[positions[3]], fields[positions[4]]));
+            } else {
+                auto object = nlohmann::json::parse(line);
+
+                if (!object.is_object()) {
+                    throw std::invalid_argument("Line is not a JSON object");
+                }
+
+                batch.push_back(make_row(field_text(object, columns[0]), field_text(object, columns[1]),
+                    field_text(object, columns[2]), field_text(object, columns[3]), field_text(object, columns[4])));
+            }
+        } catch (const nlohmann::json::exception& e) {
+            reject(line_number, e.what());
+        } catch (const std::invalid_argument& e) {
+            reject(line_number, e.what());
+        }
+
+        if (batch.size() >= batch_size) {
+            flush();
+        }
+    }
+
+    if (!header_read) {
+        throw std::invalid_argument("CSV header is missing");
+    }
+
+    flush();
+
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    std::cout << "Flight import: " << report.rows_imported << " rows imported, "
+              << report.rows_rejected << " rejected, "
+              << static_cast<long long>(report.rows_per_second()) << " rows/sec" << std::endl;
+
+    return report;
+}
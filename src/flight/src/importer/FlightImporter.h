@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "../database/FlightRepository.h"
+
+// Импорт расписания рейсов из CSV или NDJSON.
+// Поля совпадают с ответом API: flightNumber, date, fromAirport, toAirport, price.
+// Аэропорт задается id или названием ("Пулково", "Санкт-Петербург Пулково").
+// Строки читаются потоком, проверяются и пишутся в БД пачками через COPY.
+class FlightImporter {
+public:
+    enum class Format { Csv, Ndjson };
+
+    struct Report {
+        std::size_t rows_read = 0;
+        std::size_t rows_imported = 0;
+        std::size_t rows_rejected = 0;
+        double seconds = 0;
+        // Первые ошибки проверки в виде "line N: ..."
+        std::vector<std::string> errors;
+
+        double rows_per_second() const;
+        nlohmann::json to_json() const;
+    };
+
+    explicit FlightImporter(FlightRepository& repo, std::size_t batch_size = 10000);
+
+    // "csv", "ndjson"/"jsonl" или имя файла с таким расширением
+    static std::optional<Format> parse_format(std::string_view name);
+
+    Report import(std::istream& input, Format format);
+
+private:
+    static constexpr std::size_t max_reported_errors = 100;
+
+    FlightRepository& flight_repository;
+    std::size_t batch_size;
+
+    std::unordered_set<int> airport_ids;
+    // Кэш разрешенных названий аэропортов
+    std::unordered_map<std::string, int> airport_by_name;
+
+    void load_airports();
+
+    int resolve_airport(const std::string& value);
+
+    FlightRepository::FlightImportRow make_row(const std::string& flight_number,
+        const std::string& date,
+        const std::string& from_airport,
+        const std::string& to_airport,
+        const std::string& price);
+
+    static std::vector<std::string> split_csv_line(const std::string& line);
+};
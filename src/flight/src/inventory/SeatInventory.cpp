@@ -0,0 +1,195 @@
+#include "SeatInventory.h"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+SeatInventory::SeatInventory(FlightRepository& repo, std::chrono::milliseconds flush_interval)
+    : flight_repository(repo)
+    , flush_interval(flush_interval) {
+}
+
+SeatInventory::~SeatInventory() {
+    stop();
+}
+
+void SeatInventory::start() {
+    flusher = std::thread([this]() { run(); });
+}
+
+void SeatInventory::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex);
+        stopping = true;
+    }
+    stop_cv.notify_all();
+
+    if (flusher.joinable()) {
+        flusher.join();
+    }
+
+    try {
+        flush();
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Seat inventory: final flush failed: " << e.what() << std::endl;
+    }
+}
+
+void SeatInventory::run() {
+    std::unique_lock<std::mutex> lock(stop_mutex);
+
+    while (!stop_cv.wait_for(lock, flush_interval, [this]() { return stopping; })) {
+        lock.unlock();
+
+        try {
+            flush();
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Seat inventory: flush failed, will retry: " << e.what() << std::endl;
+        }
+
+        lock.lock();
+    }
+}
+
+std::shared_ptr<SeatInventory::Counter> SeatInventory::find_counter(const std::string& flight_number) {
+    {
+        std::shared_lock<std::shared_mutex> lock(counters_mutex);
+        auto it = counters.find(flight_number);
+        if (it != counters.end()) {
+            return it->second;
+        }
+    }
+
+    auto seats = flight_repository.get_seat_counts(flight_number);
+    if (!seats) {
+        return nullptr;
+    }
+
+    auto counter = std::make_shared<Counter>();
+    counter->flight_id = seats->flight_id;
+    counter->total = seats->total;
+    counter->remaining.store(seats->remaining);
+    counter->closed.store(seats->closed);
+
+    // Параллельный запрос мог загрузить счетчик раньше - используем его
+    std::unique_lock<std::shared_mutex> lock(counters_mutex);
+    return counters.emplace(flight_number, std::move(counter)).first->second;
+}
+
+SeatInventory::Outcome SeatInventory::get_availability(const std::string& flight_number) {
+    Outcome outcome;
+
+    auto counter = find_counter(flight_number);
+    if (!counter) {
+        return outcome;
+    }
+
+    outcome.status = Status::Ok;
+    outcome.availability = { counter->total, counter->remaining.load() };
+    return outcome;
+}
+
+SeatInventory::Outcome SeatInventory::reserve(const std::string& flight_number, int seats) {
+    Outcome outcome;
+
+    auto counter = find_counter(flight_number);
+    if (!counter) {
+        return outcome;
+    }
+
+    int remaining = counter->remaining.load();
+
+    do {
+        if (counter->closed.load()) {
+            outcome.status = Status::Closed;
+            outcome.availability = { counter->total, remaining };
+            return outcome;
+        }
+        if (remaining < seats) {
+            outcome.status = Status::SoldOut;
+            outcome.availability = { counter->total, remaining };
+            return outcome;
+        }
+    } while (!counter->remaining.compare_exchange_weak(remaining, remaining - seats));
+
+    counter->pending.fetch_sub(seats);
+
+    outcome.status = Status::Ok;
+    outcome.availability = { counter->total, remaining - seats };
+    return outcome;
+}
+
+SeatInventory::Outcome SeatInventory::release(const std::string& flight_number, int seats) {
+    Outcome outcome;
+
+    auto counter = find_counter(flight_number);
+    if (!counter) {
+        return outcome;
+    }
+
+    int remaining = counter->remaining.load();
+    int released = 0;
+
+    // Остаток не превышает вместимость рейса
+    do {
+        released = std::min(seats, counter->total - remaining);
+    } while (!counter->remaining.compare_exchange_weak(remaining, remaining + released));
+
+    counter->pending.fetch_add(released);
+
+    outcome.status = Status::Ok;
+    outcome.availability = { counter->total, remaining + released };
+    return outcome;
+}
+
+SeatInventory::Outcome SeatInventory::close(const std::string& flight_number) {
+    Outcome outcome;
+
+    auto counter = find_counter(flight_number);
+    if (!counter) {
+        return outcome;
+    }
+
+    // Сначала в памяти - продажи прекращаются сразу, затем в БД на случай перезапуска
+    counter->closed.store(true);
+    flight_repository.close_flight(counter->flight_id);
+
+    outcome.status = Status::Ok;
+    outcome.availability = { counter->total, counter->remaining.load() };
+    return outcome;
+}
+
+void SeatInventory::flush() {
+    std::lock_guard<std::mutex> flush_lock(flush_mutex);
+
+    std::vector<std::shared_ptr<Counter>> changed;
+    std::vector<std::pair<int, int>> deltas;
+
+    {
+        std::shared_lock<std::shared_mutex> lock(counters_mutex);
+
+        for (const auto& [flight_number, counter] : counters) {
+            int delta = counter->pending.exchange(0);
+            if (delta != 0) {
+                changed.push_back(counter);
+                deltas.emplace_back(counter->flight_id, delta);
+            }
+        }
+    }
+
+    if (deltas.empty()) {
+        return;
+    }
+
+    try {
+        flight_repository.apply_seat_deltas(deltas);
+    }
+    catch (...) {
+        // Возвращаем изменения, чтобы записать их следующим flush
+        for (std::size_t i = 0; i < changed.size(); ++i) {
+            changed[i]->pending.fetch_add(deltas[i].second);
+        }
+        throw;
+    }
+}
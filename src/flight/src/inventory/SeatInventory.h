@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "../database/FlightRepository.h"
+
+// Учет свободных мест на рейсах.
+// Остаток каждого рейса - атомарный счетчик в памяти: бронирование и возврат
+// выполняются CAS без блокировок строк в БД. Накопленные изменения фоновый
+// поток пачкой записывает в flight.seats_remaining (write-behind).
+// Рассчитано на один экземпляр flight service, который владеет остатками.
+class SeatInventory {
+public:
+    enum class Status { Ok, SoldOut, Closed, NotFound };
+
+    struct Availability {
+        int total = 0;
+        int remaining = 0;
+    };
+
+    struct Outcome {
+        Status status = Status::NotFound;
+        Availability availability;
+    };
+
+    SeatInventory(FlightRepository& repo, std::chrono::milliseconds flush_interval);
+    ~SeatInventory();
+
+    SeatInventory(const SeatInventory&) = delete;
+    SeatInventory& operator=(const SeatInventory&) = delete;
+
+    void start();
+    // Останавливает фоновый поток и записывает оставшиеся изменения
+    void stop();
+
+    Outcome get_availability(const std::string& flight_number);
+    Outcome reserve(const std::string& flight_number, int seats);
+    Outcome release(const std::string& flight_number, int seats);
+    // Закрывает рейс для продажи: дальнейшие reserve возвращают Closed
+    Outcome close(const std::string& flight_number);
+
+    // Записывает накопленные изменения в БД
+    void flush();
+
+private:
+    struct Counter {
+        int flight_id = 0;
+        int total = 0;
+        std::atomic<int> remaining{ 0 };
+        // Изменение остатка, еще не записанное в БД
+        std::atomic<int> pending{ 0 };
+        std::atomic<bool> closed{ false };
+    };
+
+    // Счетчик рейса; при первом обращении загружается из БД
+    std::shared_ptr<Counter> find_counter(const std::string& flight_number);
+
+    void run();
+
+    FlightRepository& flight_repository;
+    std::chrono::milliseconds flush_interval;
+
+    std::shared_mutex counters_mutex;
+    std::unordered_map<std::string, std::shared_ptr<Counter>> counters;
+
+    // Один flush за раз (фоновый поток и stop)
+    std::mutex flush_mutex;
+
+    std::thread flusher;
+    std::mutex stop_mutex;
+    std::condition_variable stop_cv;
+    bool stopping = false;
+};
@@ -1,10 +1,35 @@
 #include <iostream>
 #include <string>
+#include <fstream>
+#include <cstdlib>
+#include <memory>
 #include <crow.h>
 #include "api/FlightController.h"
 #include "database/FlightRepository.h"
+#include "database/Migrations.h"
+#include "catalog/FlightCatalog.h"
+#include "importer/FlightImporter.h"
+#include "inventory/SeatInventory.h"
+
+int main(int argc, char* argv[]) {
+    // --migrate-only    - применить миграции и завершить работу
+    // --skip-migrations - не применять миграции при старте
+    // --import <file>   - загрузить расписание из .csv/.ndjson и завершить работу
+    bool migrate_only = false;
+    bool skip_migrations = false;
+    std::string import_file;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--migrate-only") {
+            migrate_only = true;
+        } else if (arg == "--skip-migrations") {
+            skip_migrations = true;
+        } else if (arg == "--import" && i + 1 < argc) {
+            import_file = argv[++i];
+        }
+    }
 
-int main() {
     
     crow::SimpleApp app;
     
@@ -13,14 +38,58 @@ int main() {
     std::cout << db_connection_string << std::endl;
     
     try {
+        if (!skip_migrations) {
+            MigrationRunner migration_runner(db_connection_string, flight_migrations());
+            int applied = migration_runner.run();
+            std::cout << "Flight Service: applied migrations: " << applied << std::endl;
+        }
+
+        if (migrate_only) {
+            return 0;
+        }
+
         FlightRepository flight_repository(db_connection_string);
         
         if (!flight_repository.connect()) {
             std::cerr << "Ошибка соединения с БД flights" << std::endl;
             return 1;
         }
+
+        if (!import_file.empty()) {
+            auto format = FlightImporter::parse_format(import_file);
+            std::ifstream input(import_file);
+
+            if (!format || !input) {
+                std::cerr << "Не удалось открыть файл импорта: " << import_file << std::endl;
+                return 1;
+            }
+
+            FlightImporter importer(flight_repository);
+            std::cout << importer.import(input, *format).to_json().dump(2) << std::endl;
+            return 0;
+        }
+        
+        // FLIGHT_CATALOG_MODE=1 - чтение рейсов из каталога в памяти
+        std::unique_ptr<FlightCatalog> flight_catalog;
+        const char* catalog_mode = std::getenv("FLIGHT_CATALOG_MODE");
+
+        if (catalog_mode && std::string(catalog_mode) == "1") {
+            const char* refresh_env = std::getenv("FLIGHT_CATALOG_REFRESH_SECONDS");
+            int refresh_seconds = refresh_env ? std::stoi(refresh_env) : 5;
+
+            flight_catalog = std::make_unique<FlightCatalog>(flight_repository,
+                std::chrono::seconds(refresh_seconds > 0 ? refresh_seconds : 5));
+            flight_catalog->start();
+        }
+        
+        // FLIGHT_SEAT_FLUSH_MS - период записи остатков мест в БД
+        const char* flush_env = std::getenv("FLIGHT_SEAT_FLUSH_MS");
+        int flush_ms = flush_env ? std::stoi(flush_env) : 200;
+
+        SeatInventory seat_inventory(flight_repository, std::chrono::milliseconds(flush_ms > 0 ? flush_ms : 200));
+        seat_inventory.start();
         
-        FlightController controller(flight_repository);
+        FlightController controller(flight_repository, flight_catalog.get(), &seat_inventory);
         
         controller.router(app);
         
@@ -6,10 +6,12 @@
 
 class Airport {
 private:
-    int id;
+    int id = 0;
     std::string name;
     std::string city;
     std::string country;
+    // " " -     
+    std::string full_name;
 
 public:
     Airport() = default;
@@ -22,10 +24,19 @@ public:
         , name(name)
         , city(city)
         , country(country)
+        , full_name(city + " " + name)
     {}
     
-    std::string get_full_name() const {
-        return city + " " + name;
+    int get_id() const { return id; }
+    const std::string& get_name() const { return name; }
+    const std::string& get_city() const { return city; }
+
+    const std::string& get_full_name() const {
+        return full_name;
+    }
+
+    bool operator==(const Airport& other) const {
+        return id == other.id && name == other.name && city == other.city && country == other.country;
     }
     
     nlohmann::json to_json() const {
@@ -44,6 +55,7 @@ public:
         airport.name = j["name"];
         airport.city = j["city"];
         airport.country = j["country"];
+        airport.full_name = airport.city + " " + airport.name;
         return airport;
     }
 };
\ No newline at end of file
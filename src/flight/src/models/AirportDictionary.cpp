@@ -0,0 +1,61 @@
+#include "AirportDictionary.h"
+#include <stdexcept>
+
+AirportDictionary& AirportDictionary::instance() {
+    static AirportDictionary dictionary;
+    return dictionary;
+}
+
+std::uint32_t AirportDictionary::intern(const Airport& airport) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = latest_by_id.find(airport.get_id());
+    if (it != latest_by_id.end() && get(it->second) == airport) {
+        return it->second;
+    }
+
+    if (count >= max_chunks * chunk_size) {
+        throw std::length_error("Airport dictionary is full");
+    }
+
+    std::uint32_t index = count;
+    std::size_t chunk_index = index >> chunk_bits;
+
+    if (!chunks[chunk_index].load(std::memory_order_relaxed)) {
+        storage.push_back(std::make_unique<Airport[]>(chunk_size));
+        chunks[chunk_index].store(storage.back().get(), std::memory_order_release);
+    }
+
+    Airport* chunk = chunks[chunk_index].load(std::memory_order_relaxed);
+    chunk[index & (chunk_size - 1)] = airport;
+    ++count;
+
+    latest_by_id[airport.get_id()] = index;
+
+    for (const std::string& name : { airport.get_city(), airport.get_name(), airport.get_full_name() }) {
+        by_name[name].push_back(index);
+    }
+
+    return index;
+}
+
+std::vector<std::uint32_t> AirportDictionary::find_by_name(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::vector<std::uint32_t> result;
+
+    auto it = by_name.find(name);
+    if (it == by_name.end()) {
+        return result;
+    }
+
+    // Только актуальные версии аэропортов
+    for (std::uint32_t index : it->second) {
+        auto latest = latest_by_id.find(get(index).get_id());
+        if (latest != latest_by_id.end() && latest->second == index) {
+            result.push_back(index);
+        }
+    }
+
+    return result;
+}
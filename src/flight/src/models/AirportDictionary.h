@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Airport.h"
+
+// Общий для процесса справочник аэропортов.
+// Рейсы хранят 32-битный индекс записи вместо копий Airport. Записи только
+// добавляются и никогда не перемещаются, поэтому чтение по индексу не
+// требует блокировок. Изменившийся в БД аэропорт получает новый индекс.
+class AirportDictionary {
+public:
+    static AirportDictionary& instance();
+
+    std::uint32_t intern(const Airport& airport);
+
+    const Airport& get(std::uint32_t index) const {
+        const Airport* chunk = chunks[index >> chunk_bits].load(std::memory_order_acquire);
+        return chunk[index & (chunk_size - 1)];
+    }
+
+    // Индексы аэропортов, у которых совпадает город, название или "город название"
+    std::vector<std::uint32_t> find_by_name(const std::string& name) const;
+
+private:
+    static constexpr std::size_t chunk_bits = 10;
+    static constexpr std::size_t chunk_size = std::size_t(1) << chunk_bits;
+    static constexpr std::size_t max_chunks = 1024;
+
+    AirportDictionary() = default;
+
+    std::array<std::atomic<Airport*>, max_chunks> chunks{};
+    std::vector<std::unique_ptr<Airport[]>> storage;
+    std::uint32_t count = 0;
+
+    // Последний индекс для каждого id и индексы по именам (под mutex)
+    mutable std::mutex mutex;
+    std::unordered_map<int, std::uint32_t> latest_by_id;
+    std::unordered_map<std::string, std::vector<std::uint32_t>> by_name;
+};
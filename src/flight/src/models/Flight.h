@@ -1,66 +1,124 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <nlohmann/json.hpp>
 #include "Airport.h"
+#include "AirportDictionary.h"
+#include "InlineString.h"
+#include "../utils/DateTime.h"
+#include "../utils/JsonWriter.h"
 
+// Компактное представление рейса для каталога в памяти:
+// аэропорты - индексы в AirportDictionary, дата - секунды от эпохи,
+// номер рейса (VARCHAR(20) в БД) хранится внутри объекта.
 class Flight {
 private:
-    int id_;
-    std::string flight_number_;
-    std::string datetime_;
-    Airport from_airport_;
-    Airport to_airport_;
-    int price_;
+    std::int64_t departure_ = 0;
+    std::int32_t id_ = 0;
+    std::int32_t price_ = 0;
+    std::uint32_t from_airport_ = 0;
+    std::uint32_t to_airport_ = 0;
+    InlineString<20> flight_number_;
 
 public:
     Flight() = default;
 
     Flight(int id,
-           const std::string& flight_number, 
-           const std::string& datetime,
-           const Airport& from_airport, const Airport& to_airport,
+           std::string_view flight_number,
+           std::int64_t departure,
+           std::uint32_t from_airport, std::uint32_t to_airport,
            int price)
-        : id_(id)
-        , flight_number_(flight_number)
-        , datetime_(datetime)
+        : departure_(departure)
+        , id_(id)
+        , price_(price)
         , from_airport_(from_airport)
         , to_airport_(to_airport)
-        , price_(price)
+        , flight_number_(flight_number)
+    {}
+
+    Flight(int id,
+           const std::string& flight_number,
+           std::int64_t departure,
+           const Airport& from_airport, const Airport& to_airport,
+           int price)
+        : Flight(id, flight_number, departure,
+            AirportDictionary::instance().intern(from_airport),
+            AirportDictionary::instance().intern(to_airport),
+            price)
     {}
-    
+
+    int get_id() const { return id_; }
+    std::string_view get_flight_number() const { return flight_number_.view(); }
+    const Airport& get_from_airport() const { return AirportDictionary::instance().get(from_airport_); }
+    const Airport& get_to_airport() const { return AirportDictionary::instance().get(to_airport_); }
+    int get_price() const { return price_; }
+    std::int64_t get_departure() const { return departure_; }
+
     std::string get_datetime_string() const {
-        return datetime_;
+        return date_time::format(departure_);
     }
-    
+
     // Для ответа API
     nlohmann::json to_api_json() const {
         return {
-            {"flightNumber", flight_number_},
-            {"fromAirport", from_airport_.get_full_name()},
-            {"toAirport", to_airport_.get_full_name()},
+            {"flightNumber", flight_number_.str()},
+            {"fromAirport", get_from_airport().get_full_name()},
+            {"toAirport", get_to_airport().get_full_name()},
             {"date", get_datetime_string()},
             {"price", price_}
         };
     }
-    
+
+    // То же, что to_api_json().dump(), но без построения DOM.
+    // Ключи в алфавитном порядке, как их выводит nlohmann::json.
+    std::string to_api_json_fragment() const {
+        const std::string& from_airport = get_from_airport().get_full_name();
+        const std::string& to_airport = get_to_airport().get_full_name();
+
+        std::string out;
+        out.reserve(96 + flight_number_.size() + from_airport.size() + to_airport.size());
+
+        out.push_back('{');
+        json_writer::append_key(out, "date");
+        out.push_back('"');
+        date_time::append(out, departure_);
+        out.push_back('"');
+        out.push_back(',');
+        json_writer::append_key(out, "flightNumber");
+        json_writer::append_string(out, flight_number_.view());
+        out.push_back(',');
+        json_writer::append_key(out, "fromAirport");
+        json_writer::append_string(out, from_airport);
+        out.push_back(',');
+        json_writer::append_key(out, "price");
+        json_writer::append_int(out, price_);
+        out.push_back(',');
+        json_writer::append_key(out, "toAirport");
+        json_writer::append_string(out, to_airport);
+        out.push_back('}');
+
+        return out;
+    }
+
     nlohmann::json to_json() const {
         return {
             {"id", id_},
-            {"flight_number", flight_number_},
+            {"flight_number", flight_number_.str()},
             {"datetime", get_datetime_string()},
-            {"from_airport", from_airport_.to_json()},
-            {"to_airport", to_airport_.to_json()},
+            {"from_airport", get_from_airport().to_json()},
+            {"to_airport", get_to_airport().to_json()},
             {"price", price_}
         };
     }
-    
+
     // Из базы
     static Flight from_json(const nlohmann::json& j) {
         Flight flight;
         flight.id_ = j["id"];
-        flight.flight_number_ = j["flight_number"];
+        flight.flight_number_.assign(j["flight_number"].get<std::string>());
         flight.price_ = j["price"];
         return flight;
     }
-};
\ No newline at end of file
+};
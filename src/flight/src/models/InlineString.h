@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// Строка фиксированной емкости без выделения памяти в куче
+template <std::size_t Capacity>
+class InlineString {
+    static_assert(Capacity < 256, "InlineString length is stored in one byte");
+
+private:
+    char data_[Capacity];
+    std::uint8_t size_ = 0;
+
+public:
+    InlineString() = default;
+
+    InlineString(std::string_view value) {
+        assign(value);
+    }
+
+    void assign(std::string_view value) {
+        if (value.size() > Capacity) {
+            throw std::length_error("String exceeds inline capacity: " + std::string(value));
+        }
+
+        std::memcpy(data_, value.data(), value.size());
+        size_ = static_cast<std::uint8_t>(value.size());
+    }
+
+    std::string_view view() const { return std::string_view(data_, size_); }
+    std::string str() const { return std::string(data_, size_); }
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    bool operator==(std::string_view other) const { return view() == other; }
+    bool operator!=(std::string_view other) const { return view() != other; }
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Дата и время вылета хранятся как число секунд от 1970-01-01 00:00 в том же
+// гражданском времени, в котором их вернула БД (без сдвига часового пояса),
+// поэтому форматирование восстанавливает исходную строку.
+namespace date_time {
+
+    // Дни от 1970-01-01 для григорианской даты (алгоритм Howard Hinnant)
+    inline std::int64_t days_from_civil(std::int64_t y, unsigned m, unsigned d) {
+        y -= m <= 2;
+        const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+        const unsigned yoe = static_cast<unsigned>(y - era * 400);
+        const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+    }
+
+    inline void civil_from_days(std::int64_t z, std::int64_t& y, unsigned& m, unsigned& d) {
+        z += 719468;
+        const std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+        const unsigned doe = static_cast<unsigned>(z - era * 146097);
+        const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const unsigned mp = (5 * doy + 2) / 153;
+        d = doy - (153 * mp + 2) / 5 + 1;
+        m = mp < 10 ? mp + 3 : mp - 9;
+        y = static_cast<std::int64_t>(yoe) + era * 400 + (m <= 2);
+    }
+
+    inline unsigned days_in_month(std::int64_t y, unsigned m) {
+        static const unsigned days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+        const bool leap = y % 4 == 0 && (y % 100 != 0 || y % 400 == 0);
+        return m == 2 && leap ? 29 : days[m - 1];
+    }
+
+    inline bool parse_digits(std::string_view text, std::size_t pos, std::size_t count, unsigned& value) {
+        if (pos + count > text.size()) {
+            return false;
+        }
+
+        value = 0;
+        for (std::size_t i = pos; i < pos + count; ++i) {
+            unsigned digit = static_cast<unsigned>(text[i] - '0');
+            if (digit > 9) {
+                return false;
+            }
+            value = value * 10 + digit;
+        }
+
+        return true;
+    }
+
+    // "YYYY-MM-DD", "YYYY-MM-DD HH:MM" или полная метка времени Postgres.
+    // Секунды и часовой пояс отбрасываются: API отдает время с точностью до минуты.
+    inline std::optional<std::int64_t> parse(std::string_view text) {
+        unsigned year, month, day, hour = 0, minute = 0;
+
+        if (!parse_digits(text, 0, 4, year) || text.size() < 10 || text[4] != '-' ||
+            !parse_digits(text, 5, 2, month) || text[7] != '-' ||
+            !parse_digits(text, 8, 2, day)) {
+            return std::nullopt;
+        }
+
+        if (text.size() > 10) {
+            if ((text[10] != ' ' && text[10] != 'T') || text.size() < 16 ||
+                !parse_digits(text, 11, 2, hour) || text[13] != ':' ||
+                !parse_digits(text, 14, 2, minute)) {
+                return std::nullopt;
+            }
+        }
+
+        if (month < 1 || month > 12 || day < 1 || day > days_in_month(year, month) ||
+            hour > 23 || minute > 59) {
+            return std::nullopt;
+        }
+
+        return days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60;
+    }
+
+    // Строгий разбор входных данных (импорт): "YYYY-MM-DD", "YYYY-MM-DD HH:MM"
+    // или "YYYY-MM-DD HH:MM:00". Часовой пояс и любой другой хвост не
+    // принимаются - время хранится без пояса, и parse() его бы просто отбросил.
+    inline std::optional<std::int64_t> parse_exact(std::string_view text) {
+        if (text.size() == 19) {
+            unsigned second;
+            if (text[16] != ':' || !parse_digits(text, 17, 2, second) || second != 0) {
+                return std::nullopt;
+            }
+            text = text.substr(0, 16);
+        }
+
+        if (text.size() != 10 && text.size() != 16) {
+            return std::nullopt;
+        }
+
+        return parse(text);
+    }
+
+    // Дописывает "YYYY-MM-DD HH:MM"
+    inline void append(std::string& out, std::int64_t seconds) {
+        std::int64_t days = seconds >= 0 ? seconds / 86400 : (seconds - 86399) / 86400;
+        std::int64_t rest = seconds - days * 86400;
+
+        std::int64_t year;
+        unsigned month, day;
+        civil_from_days(days, year, month, day);
+
+        unsigned hour = static_cast<unsigned>(rest / 3600);
+        unsigned minute = static_cast<unsigned>(rest % 3600 / 60);
+
+        char buffer[16];
+        unsigned y = static_cast<unsigned>(year);
+        buffer[0] = static_cast<char>('0' + y / 1000 % 10);
+        buffer[1] = static_cast<char>('0' + y / 100 % 10);
+        buffer[2] = static_cast<char>('0' + y / 10 % 10);
+        buffer[3] = static_cast<char>('0' + y % 10);
+        buffer[4] = '-';
+        buffer[5] = static_cast<char>('0' + month / 10);
+        buffer[6] = static_cast<char>('0' + month % 10);
+        buffer[7] = '-';
+        buffer[8] = static_cast<char>('0' + day / 10);
+        buffer[9] = static_cast<char>('0' + day % 10);
+        buffer[10] = ' ';
+        buffer[11] = static_cast<char>('0' + hour / 10);
+        buffer[12] = static_cast<char>('0' + hour % 10);
+        buffer[13] = ':';
+        buffer[14] = static_cast<char>('0' + minute / 10);
+        buffer[15] = static_cast<char>('0' + minute % 10);
+
+        out.append(buffer, sizeof(buffer));
+    }
+
+    inline std::string format(std::int64_t seconds) {
+        std::string out;
+        out.reserve(16);
+        append(out, seconds);
+        return out;
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Запись JSON напрямую в строку, без построения nlohmann::json.
+// Экранирование совпадает с nlohmann::json::dump(), поэтому фрагменты
+// можно склеивать с результатами dump() побайтно.
+namespace json_writer {
+
+    inline void append_string(std::string& out, std::string_view value) {
+        static const char hex[] = "0123456789abcdef";
+
+        out.push_back('"');
+
+        for (char c : value) {
+            switch (c) {
+            case '"':  out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\b': out.append("\\b"); break;
+            case '\f': out.append("\\f"); break;
+            case '\n': out.append("\\n"); break;
+            case '\r': out.append("\\r"); break;
+            case '\t': out.append("\\t"); break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out.append("\\u00");
+                    out.push_back(hex[(c >> 4) & 0x0F]);
+                    out.push_back(hex[c & 0x0F]);
+                }
+                else {
+                    out.push_back(c);
+                }
+            }
+        }
+
+        out.push_back('"');
+    }
+
+    inline void append_int(std::string& out, long long value) {
+        out.append(std::to_string(value));
+    }
+
+    // "key":
+    inline void append_key(std::string& out, std::string_view key) {
+        append_string(out, key);
+        out.push_back(':');
+    }
+}
@@ -152,6 +152,65 @@ crow::response GatewayController::health_check() {
     }
 }
 
+bool GatewayController::is_admin_request(const crow::request& req) const {
+    if (admin_token.empty()) {
+        return false;
+    }
+
+    std::string token = req.get_header_value("X-Admin-Token");
+    if (token.size() != admin_token.size()) {
+        return false;
+    }
+
+    // Сравнение без раннего выхода - время не зависит от совпавшего префикса
+    unsigned char diff = 0;
+    for (std::size_t i = 0; i < token.size(); ++i) {
+        diff |= static_cast<unsigned char>(token[i] ^ admin_token[i]);
+    }
+    return diff == 0;
+}
+
+// POST /manage/flights/{flightNumber}/cancel
+crow::response GatewayController::cancel_flight(const crow::request& req, const std::string& flight_number) {
+    if (!is_admin_request(req)) {
+        return create_error_response(403, "Forbidden");
+    }
+
+    if (!cancellation_jobs) {
+        return create_error_response(503, "Flight cancellation is not available");
+    }
+
+    try {
+        auto progress = cancellation_jobs->start(flight_number);
+
+        crow::response res(202, progress.to_json().dump());
+        res.set_header("Content-Type", "application/json");
+        res.set_header("Location", "/manage/flight-cancellations/" + progress.job_id);
+        return res;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error in cancel_flight: " << e.what() << std::endl;
+        return create_error_response(500, "Failed to start flight cancellation");
+    }
+}
+
+// GET /manage/flight-cancellations/{jobId}
+crow::response GatewayController::get_flight_cancellation(const crow::request& req, const std::string& job_id) {
+    if (!is_admin_request(req)) {
+        return create_error_response(403, "Forbidden");
+    }
+
+    auto progress = cancellation_jobs ? cancellation_jobs->get(job_id) : std::nullopt;
+
+    if (!progress) {
+        return create_error_response(404, "Cancellation job not found");
+    }
+
+    crow::response res(200, progress->to_json().dump());
+    res.set_header("Content-Type", "application/json");
+    return res;
+}
+
 // Создание ошибки
 crow::response GatewayController::create_error_response(int status_code, const std::string& message) {
     nlohmann::json error = {
@@ -245,7 +304,7 @@ pplx::task<web::json::value> GatewayController::call_service_async(
 
         return client.request(request).then([](http_response response) {
             if (response.status_code() >= 400) {
-                throw std::runtime_error("HTTP error: " + std::to_string(response.status_code()));
+                throw ServiceError(response.status_code());
             }
 
             if (response.status_code() == 204) {
@@ -331,6 +390,49 @@ crow::response GatewayController::get_flights(const crow::request& req) {
     }
 }
 
+// GET /api/v1/flights/search - поиск рейсов в Flight Service
+crow::response GatewayController::search_flights(const crow::request& req) {
+    try {
+        static const char* params[] = {
+            "from", "to", "dateFrom", "dateTo", "minPrice", "maxPrice", "sort", "page", "size"
+        };
+
+        std::stringstream flight_url;
+        flight_url << flight_service_url << "/api/v1/flights/search";
+
+        char separator = '?';
+        for (const char* param : params) {
+            const char* value = req.url_params.get(param);
+            if (value) {
+                flight_url << separator << param << "="
+                    << to_utf8string(web::uri::encode_data_string(to_string_t(value)));
+                separator = '&';
+            }
+        }
+
+        auto flight_response = call_service_sync(flight_url.str());
+
+        std::string response_str = to_utf8string(flight_response.serialize());
+
+        crow::response res(200, response_str);
+        res.set_header("Content-Type", "application/json");
+        return res;
+
+    }
+    catch (const ServiceError& e) {
+        // Ошибка параметров в Flight Service - ошибка клиента
+        if (e.get_status_code() >= 400 && e.get_status_code() < 500) {
+            return create_error_response(e.get_status_code(), "Invalid search parameters");
+        }
+        std::cerr << "Error in search_flights: " << e.what() << std::endl;
+        return create_error_response(500, "Failed to search flights");
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error in search_flights: " << e.what() << std::endl;
+        return create_error_response(500, "Failed to search flights");
+    }
+}
+
 // GET /api/v1/me - полная информация о пользователе
 crow::response GatewayController::get_user_info(const crow::request& req) {
     try {
@@ -412,8 +514,8 @@ crow::response GatewayController::get_user_info(const crow::request& req) {
 
         // 2. Получаем информацию о привилегиях
         try {
-            std::string privilege_url = bonus_service_url + "/api/v1/privilege";
-            auto privilege_response = call_service_with_auth_sync(privilege_url, methods::GET, username);
+            // Для /me нужен только баланс
+            auto privilege_response = get_privilege_summary(username);
 
             int balance = get_json_int_field(privilege_response, "balance", 0);
             std::string status = get_json_string_field(privilege_response, "status", "BRONZE");
@@ -450,30 +552,59 @@ crow::response GatewayController::get_user_tickets(const crow::request& req) {
             return create_error_response(400, "X-User-Name header is required");
         }
 
-        std::string tickets_url = ticket_service_url + "/api/v1/tickets";
-        auto tickets_response = call_service_with_auth_sync(tickets_url, methods::GET, username);
+        static const char* params[] = { "page", "size", "cursor", "status" };
+
+        std::stringstream tickets_url;
+        tickets_url << ticket_service_url << "/api/v1/tickets";
+
+        char separator = '?';
+        for (const char* param : params) {
+            const char* value = req.url_params.get(param);
+            if (value) {
+                tickets_url << separator << param << "="
+                    << to_utf8string(web::uri::encode_data_string(to_string_t(value)));
+                separator = '&';
+            }
+        }
+
+        auto tickets_response = call_service_with_auth_sync(tickets_url.str(), methods::GET, username);
 
         std::string tickets_str = to_utf8string(tickets_response.serialize());
-        nlohmann::json tickets_array = nlohmann::json::parse(tickets_str);
+        nlohmann::json tickets_json = nlohmann::json::parse(tickets_str);
+
+        // С параметрами пагинации Ticket Service возвращает {"items": [...], ...}
+        bool paginated = tickets_json.is_object();
+        const nlohmann::json& tickets_array = paginated ? tickets_json["items"] : tickets_json;
+
+        // Рейс запрашивается один раз на номер в пределах ответа
+        std::map<std::string, nlohmann::json> flights;
 
         nlohmann::json full_tickets = nlohmann::json::array();
 
-        for (auto& ticket : tickets_array) {
+        for (const auto& ticket : tickets_array) {
             std::string flight_number = ticket["flightNumber"];
             std::string ticket_uid = ticket["ticketUid"];
-			
-            nlohmann::json flight_info;
-            try {
-                std::string flight_url = flight_service_url + "/api/v1/flights/" + flight_number;
-                auto flight_response = call_service_sync(flight_url, methods::GET);
 
-                std::string flight_str = to_utf8string(flight_response.serialize());
-                flight_info = nlohmann::json::parse(flight_str);
-            }
-            catch (...) {
-                flight_info = nlohmann::json::object();
+            auto flight_it = flights.find(flight_number);
+
+            if (flight_it == flights.end()) {
+                nlohmann::json flight_info;
+                try {
+                    std::string flight_url = flight_service_url + "/api/v1/flights/" + flight_number;
+                    auto flight_response = call_service_sync(flight_url, methods::GET);
+
+                    std::string flight_str = to_utf8string(flight_response.serialize());
+                    flight_info = nlohmann::json::parse(flight_str);
+                }
+                catch (...) {
+                    flight_info = nlohmann::json::object();
+                }
+
+                flight_it = flights.emplace(flight_number, std::move(flight_info)).first;
             }
 
+            const nlohmann::json& flight_info = flight_it->second;
+
             nlohmann::json full_ticket;
             full_ticket["ticketUid"] = ticket_uid;
             full_ticket["flightNumber"] = flight_number;
@@ -504,11 +635,26 @@ crow::response GatewayController::get_user_tickets(const crow::request& req) {
             full_tickets.push_back(full_ticket);
         }
 
-        crow::response res(200, full_tickets.dump());
+        nlohmann::json response = full_tickets;
+
+        if (paginated) {
+            response = tickets_json;
+            response["items"] = full_tickets;
+        }
+
+        crow::response res(200, response.dump());
         res.set_header("Content-Type", "application/json");
         return res;
 
     }
+    catch (const ServiceError& e) {
+        // Неверные page/size/cursor/status - ошибка клиента
+        if (e.get_status_code() >= 400 && e.get_status_code() < 500) {
+            return create_error_response(e.get_status_code(), "Invalid query parameters");
+        }
+        std::cerr << "Error in get_user_tickets: " << e.what() << std::endl;
+        return create_error_response(500, "Failed to get user tickets");
+    }
     catch (const std::exception& e) {
         std::cerr << "Error in get_user_tickets: " << e.what() << std::endl;
         return create_error_response(500, "Failed to get user tickets");
@@ -606,8 +752,22 @@ crow::response GatewayController::get_privilege_info(const crow::request& req) {
             return create_error_response(400, "X-User-Name header is required");
         }
 
-        std::string privilege_url = bonus_service_url + "/api/v1/privilege";
-        auto privilege_response = call_service_with_auth_sync(privilege_url, methods::GET, username);
+        static const char* params[] = { "limit", "cursor", "history" };
+
+        std::stringstream privilege_url;
+        privilege_url << bonus_service_url << "/api/v1/privilege";
+
+        char separator = '?';
+        for (const char* param : params) {
+            const char* value = req.url_params.get(param);
+            if (value) {
+                privilege_url << separator << param << "="
+                    << to_utf8string(web::uri::encode_data_string(to_string_t(value)));
+                separator = '&';
+            }
+        }
+
+        auto privilege_response = call_service_with_auth_sync(privilege_url.str(), methods::GET, username);
 
         if (privilege_response.is_null()) {
             return create_error_response(404, "Privilege not found");
@@ -639,11 +799,26 @@ crow::response GatewayController::get_privilege_info(const crow::request& req) {
             final_response["history"] = nlohmann::json::array();
         }
 
+        if (privilege_json.contains("nextCursor")) {
+            final_response["nextCursor"] = privilege_json["nextCursor"];
+        }
+
         crow::response res(200, final_response.dump());
         res.set_header("Content-Type", "application/json");
         return res;
 
     }
+    catch (const ServiceError& e) {
+        if (e.get_status_code() == 404) {
+            return create_error_response(404, "Privilege not found");
+        }
+        // Неверные limit/cursor - ошибка клиента
+        if (e.get_status_code() >= 400 && e.get_status_code() < 500) {
+            return create_error_response(e.get_status_code(), "Invalid query parameters");
+        }
+        std::cerr << "Error in get_privilege_info: " << e.what() << std::endl;
+        return create_error_response(500, "Failed to get privilege info");
+    }
     catch (const std::exception& e) {
         std::cerr << "Error in get_privilege_info: " << e.what() << std::endl;
         return create_error_response(500, "Failed to get privilege info");
@@ -679,12 +854,29 @@ crow::response GatewayController::purchase_ticket(const crow::request& req) {
             return create_error_response(400, "Flight not found");
         }
 
+        // Бронируем место до создания билета
+        std::string seats_url = flight_service_url + "/api/v1/flights/" + flight_number + "/seats";
+        try {
+            call_service_sync(seats_url + "/reserve", methods::POST);
+        }
+        catch (const ServiceError& e) {
+            if (e.get_status_code() == 409) {
+                return create_error_response(409, "No seats available");
+            }
+            std::cerr << "Failed to reserve seat on flight " << flight_number << ": " << e.what() << std::endl;
+            return create_error_response(500, "Failed to reserve seat");
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Failed to reserve seat on flight " << flight_number << ": " << e.what() << std::endl;
+            return create_error_response(500, "Failed to reserve seat");
+        }
+
         // 2. Получаем информацию о текущем балансе привилегий
-        std::string privilege_url = bonus_service_url + "/api/v1/privilege";
+        // История не нужна - только баланс до и после покупки
         int current_balance = 0;
 
         try {
-            auto current_privilege = call_service_with_auth_sync(privilege_url, methods::GET, username);
+            auto current_privilege = get_privilege_summary(username);
             current_balance = get_json_int_field(current_privilege, "balance", 0);
         }
         catch (...) {
@@ -714,14 +906,24 @@ crow::response GatewayController::purchase_ticket(const crow::request& req) {
         ticket_request[to_string_t("price")] = web::json::value::number(price);
 
         std::string create_ticket_url = ticket_service_url + "/api/v1/tickets";
-        auto ticket_response = call_service_with_auth_sync(create_ticket_url, methods::POST, username, ticket_request);
+        web::json::value ticket_response;
+
+        try {
+            ticket_response = call_service_with_auth_sync(create_ticket_url, methods::POST, username, ticket_request);
+        }
+        catch (const std::exception& e) {
+            release_seat(flight_number);
+            throw;
+        }
 
         if (ticket_response.is_null()) {
+            release_seat(flight_number);
             return create_error_response(500, "Failed to create ticket");
         }
 
         std::string ticket_uid = get_json_string_field(ticket_response, "ticketUid", "");
         if (ticket_uid.empty()) {
+            release_seat(flight_number);
             return create_error_response(500, "Failed to get ticket UID");
         }
 
@@ -752,7 +954,7 @@ crow::response GatewayController::purchase_ticket(const crow::request& req) {
         // 6. Получаем обновленную информацию о привилегиях
         web::json::value updated_privilege;
         try {
-            updated_privilege = call_service_with_auth_sync(privilege_url, methods::GET, username);
+            updated_privilege = get_privilege_summary(username);
         }
         catch (...) {
             updated_privilege = web::json::value::object();
@@ -799,6 +1001,31 @@ crow::response GatewayController::purchase_ticket(const crow::request& req) {
     }
 }
 
+web::json::value GatewayController::get_privilege_summary(const std::string& username) {
+    if (!privilege_batcher) {
+        return call_service_with_auth_sync(bonus_service_url + "/api/v1/privilege?history=false",
+            methods::GET, username);
+    }
+
+    auto privilege = privilege_batcher->get_privilege(username);
+
+    web::json::value summary = web::json::value::object();
+    summary[to_string_t("balance")] = web::json::value::number(privilege.balance);
+    summary[to_string_t("status")] = web::json::value::string(to_string_t(privilege.status));
+    return summary;
+}
+
+void GatewayController::release_seat(const std::string& flight_number) {
+    std::string release_url = flight_service_url + "/api/v1/flights/" + flight_number + "/seats/release";
+
+    try {
+        call_service_sync(release_url, methods::POST);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Failed to release seat on flight " << flight_number << ": " << e.what() << std::endl;
+    }
+}
+
 // DELETE /api/v1/tickets/{ticketUid} - возврат билета
 crow::response GatewayController::refund_ticket(const crow::request& req, const std::string& ticket_uid) {
     try {
@@ -812,81 +1039,54 @@ crow::response GatewayController::refund_ticket(const crow::request& req, const
             return create_error_response(400, "Ticket UID is required");
         }
 
-        // 1. Получаем информацию о билете
-        std::string get_ticket_url = ticket_service_url + "/api/v1/tickets/" + ticket_uid;
-        auto ticket_info = call_service_with_auth_sync(get_ticket_url, methods::GET, username);
-
-        if (ticket_info.is_null()) {
-            return create_error_response(404, "Ticket not found");
-        }
-		
-        std::string status = get_json_string_field(ticket_info, "status", "");
-
-        if (status == "CANCELED") {
-            return create_error_response(400, "Ticket already canceled");
-        }
+        // 1. Отменяем билет; в ответе - билет до отмены
+        std::string cancel_ticket_url = ticket_service_url + "/api/v1/tickets/" + ticket_uid;
+        web::json::value ticket_info;
 
-        // 2. Получаем информацию о бонусной операции для этого билета
-        std::string privilege_url = bonus_service_url + "/api/v1/privilege";
-        auto privilege_info = call_service_with_auth_sync(privilege_url, methods::GET, username);
-
-        bool bonus_operation_found = false;
-        int bonus_diff_for_refund = 0;
-
-        if (!privilege_info.is_null() && privilege_info.has_field(to_string_t("history"))) {
-            auto history_value = get_json_array_as_value(privilege_info, "history");
-            if (history_value.is_array()) {
-                auto history_array = history_value.as_array();
-                for (const auto& item : history_array) {
-                    if (!item.is_null() && item.has_field(to_string_t("ticketUid"))) {
-                        std::string history_ticket_uid = get_json_string_field(item, "ticketUid");
-                        if (history_ticket_uid == ticket_uid) {
-                            bonus_operation_found = true;
-
-                            int original_diff = get_json_int_field(item, "balanceDiff", 0);
-                            std::string operation_type = get_json_string_field(item, "operationType");
-
-                            if (operation_type == "DEBIT_THE_ACCOUNT") {
-                                bonus_diff_for_refund = -original_diff;
-                            }
-                            else if (operation_type == "FILL_IN_BALANCE") {
-                                bonus_diff_for_refund = -original_diff;
-                            }
-                            break;
-                        }
-                    }
-                }
-            }
+        try {
+            ticket_info = call_service_with_auth_sync(cancel_ticket_url, methods::DEL, username);
         }
-
-        // 3. Обновляем баланс привилегий (если была операция)
-        if (bonus_operation_found && bonus_diff_for_refund != 0) {
-            web::json::value bonus_update;
-            bonus_update[to_string_t("username")] = web::json::value::string(to_string_t(username));
-            bonus_update[to_string_t("ticketUid")] = web::json::value::string(to_string_t(ticket_uid));
-            bonus_update[to_string_t("balanceDiff")] = web::json::value::number(bonus_diff_for_refund);
-
-            if (bonus_diff_for_refund > 0) {
-
-                bonus_update[to_string_t("operationType")] = web::json::value::string(to_string_t("FILL_IN_BALANCE"));
+        catch (const ServiceError& e) {
+            if (e.get_status_code() == 404) {
+                return create_error_response(404, "Ticket not found");
             }
-            else {
-
-                bonus_update[to_string_t("operationType")] = web::json::value::string(to_string_t("DEBIT_THE_ACCOUNT"));
+            if (e.get_status_code() != 409) {
+                throw;
             }
 
-            std::string bonus_update_url = bonus_service_url + "/api/v1/privilege/update";
+            // Билет уже отменен: повтор после сбоя бонусного шага доводит возврат
+            // до конца. Если отменять нечего - это обычный повторный возврат.
+            std::string bonus_status;
             try {
-                call_service_sync(bonus_update_url, methods::POST, bonus_update);
+                bonus_status = reverse_ticket_bonus(username, ticket_uid);
             }
-            catch (const std::exception& e) {
-                std::cerr << "Failed to update bonus balance for refund: " << e.what() << std::endl;
+            catch (const std::exception& reverse_error) {
+                std::cerr << "Failed to reverse bonus for canceled ticket: " << reverse_error.what() << std::endl;
+                return create_error_response(502, "Bonus refund failed, retry the request");
+            }
+
+            if (bonus_status == "REVERSED") {
+                return crow::response(204);
             }
+            return create_error_response(400, "Ticket already canceled");
         }
 
-        // 4. Помечаем билет как отмененный
-        std::string cancel_ticket_url = ticket_service_url + "/api/v1/tickets/" + ticket_uid;
-        call_service_with_auth_sync(cancel_ticket_url, methods::DEL, username);
+        // 2. Возвращаем место на рейс
+        std::string flight_number = get_json_string_field(ticket_info, "flightNumber", "");
+        if (!flight_number.empty()) {
+            release_seat(flight_number);
+        }
+
+        // 3. Отменяем бонусную операцию по билету. Отмена идемпотентна и
+        // совпадает с отменой в фоновой задаче отмены рейса - повтор (запроса
+        // или задачи) не меняет баланс второй раз.
+        try {
+            reverse_ticket_bonus(username, ticket_uid);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Failed to reverse bonus for refund: " << e.what() << std::endl;
+            return create_error_response(502, "Bonus refund failed, retry the request");
+        }
 
         return crow::response(204);
 
@@ -897,6 +1097,26 @@ crow::response GatewayController::refund_ticket(const crow::request& req, const
     }
 }
 
+// Отмена бонусной операции по билету через /privilege/reverse.
+// Возвращает статус отмены (REVERSED, ALREADY_REVERSED, NOT_FOUND, ...).
+std::string GatewayController::reverse_ticket_bonus(const std::string& username, const std::string& ticket_uid) {
+    web::json::value entry;
+    entry[to_string_t("username")] = web::json::value::string(to_string_t(username));
+    entry[to_string_t("ticketUid")] = web::json::value::string(to_string_t(ticket_uid));
+
+    web::json::value body;
+    body[to_string_t("entries")] = web::json::value::array({ entry });
+
+    auto response = call_service_sync(bonus_service_url + "/api/v1/privilege/reverse", methods::POST, body);
+    auto results = get_json_array_as_value(response, "results");
+
+    if (!results.is_array() || results.as_array().size() != 1) {
+        throw std::runtime_error("Unexpected reverse response");
+    }
+
+    return get_json_string_field(results.as_array().at(0), "status");
+}
+
 // Роутер
 void GatewayController::router(crow::SimpleApp& app) {
     // Health check
@@ -913,6 +1133,13 @@ void GatewayController::router(crow::SimpleApp& app) {
         return this->get_flights(req);
             });
 
+    // GET /api/v1/flights/search
+    CROW_ROUTE(app, "/api/v1/flights/search")
+        .methods("GET"_method)
+        ([this](const crow::request& req) {
+        return this->search_flights(req);
+            });
+
     // GET /api/v1/me
     CROW_ROUTE(app, "/api/v1/me")
         .methods("GET"_method)
@@ -954,4 +1181,18 @@ void GatewayController::router(crow::SimpleApp& app) {
         ([this](const crow::request& req) {
         return this->get_privilege_info(req);
             });
+
+    // POST /manage/flights/{flightNumber}/cancel - отмена всех билетов рейса (фоновая задача, X-Admin-Token)
+    CROW_ROUTE(app, "/manage/flights/<string>/cancel")
+        .methods("POST"_method)
+        ([this](const crow::request& req, const std::string& flight_number) {
+        return this->cancel_flight(req, flight_number);
+            });
+
+    // GET /manage/flight-cancellations/{jobId} - ход отмены рейса (X-Admin-Token)
+    CROW_ROUTE(app, "/manage/flight-cancellations/<string>")
+        .methods("GET"_method)
+        ([this](const crow::request& req, const std::string& job_id) {
+        return this->get_flight_cancellation(req, job_id);
+            });
 }
\ No newline at end of file
@@ -6,6 +6,23 @@
 #include <string>
 #include <map>
 #include <vector>
+#include <stdexcept>
+#include "../client/PrivilegeBatcher.hpp"
+#include "../jobs/FlightCancellationJobs.hpp"
+
+// Ответ нижележащего сервиса с HTTP статусом >= 400
+class ServiceError : public std::runtime_error {
+public:
+    explicit ServiceError(int status_code)
+        : std::runtime_error("HTTP error: " + std::to_string(status_code))
+        , status_code(status_code) {
+    }
+
+    int get_status_code() const { return status_code; }
+
+private:
+    int status_code;
+};
 
 class GatewayController {
 private:
@@ -15,13 +32,28 @@ private:
 
     web::http::client::http_client_config client_config;
 
+    // Пакетные запросы баланса; nullptr - по запросу на пользователя
+    PrivilegeBatcher* privilege_batcher;
+
+    // Фоновая отмена рейсов; nullptr - endpoint отмены недоступен
+    FlightCancellationJobs* cancellation_jobs;
+
+    // Значение X-Admin-Token для /manage/flights/...; пусто - endpoint недоступен
+    std::string admin_token;
+
 public:
     GatewayController(const std::string& flight_url,
         const std::string& ticket_url,
-        const std::string& bonus_url)
+        const std::string& bonus_url,
+        PrivilegeBatcher* privilege_batcher = nullptr,
+        FlightCancellationJobs* cancellation_jobs = nullptr,
+        const std::string& admin_token = "")
         : flight_service_url(flight_url)
         , ticket_service_url(ticket_url)
-        , bonus_service_url(bonus_url) {
+        , bonus_service_url(bonus_url)
+        , privilege_batcher(privilege_batcher)
+        , cancellation_jobs(cancellation_jobs)
+        , admin_token(admin_token) {
 
         client_config.set_timeout(std::chrono::seconds(10));
     }
@@ -34,12 +66,27 @@ private:
 
     // API endpoints
     crow::response get_flights(const crow::request& req);
+    crow::response search_flights(const crow::request& req);
     crow::response get_user_info(const crow::request& req);
     crow::response get_user_tickets(const crow::request& req);
     crow::response get_ticket_by_uid(const crow::request& req, const std::string& ticket_uid);
     crow::response get_privilege_info(const crow::request& req);
     crow::response purchase_ticket(const crow::request& req);
     crow::response refund_ticket(const crow::request& req, const std::string& ticket_uid);
+    crow::response cancel_flight(const crow::request& req, const std::string& flight_number);
+    crow::response get_flight_cancellation(const crow::request& req, const std::string& job_id);
+
+    // Проверка X-Admin-Token служебных endpoint'ов
+    bool is_admin_request(const crow::request& req) const;
+
+    // Баланс и статус пользователя ({"balance", "status"}) без истории
+    web::json::value get_privilege_summary(const std::string& username);
+
+    // Идемпотентная отмена бонусной операции по билету; статус из Bonus Service
+    std::string reverse_ticket_bonus(const std::string& username, const std::string& ticket_uid);
+
+    // Возврат места на рейс; ошибки только логируются
+    void release_seat(const std::string& flight_number);
 
     crow::response create_error_response(int status_code, const std::string& message);
     crow::response validate_purchase_request(const nlohmann::json& json_body);
@@ -0,0 +1,133 @@
+#include "PrivilegeBatcher.hpp"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+#include "../api/GatewayController.hpp"
+
+using namespace web::http;
+using namespace web::http::client;
+
+PrivilegeBatcher::PrivilegeBatcher(const std::string& bonus_url,
+    const http_client_config& client_config,
+    std::size_t max_batch,
+    std::chrono::microseconds max_wait)
+    : batch_url(bonus_url + "/api/v1/privilege/batch")
+    , client_config(client_config)
+    , max_batch(std::clamp<std::size_t>(max_batch, 1, max_batch_limit))
+    , max_wait(max_wait) {
+}
+
+PrivilegeBatcher::~PrivilegeBatcher() {
+    stop();
+}
+
+void PrivilegeBatcher::start() {
+    sender = std::thread([this]() { run(); });
+}
+
+void PrivilegeBatcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+
+    if (sender.joinable()) {
+        sender.join();
+    }
+}
+
+PrivilegeBatcher::PrivilegeInfo PrivilegeBatcher::get_privilege(const std::string& username) {
+    std::future<PrivilegeInfo> result;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (stopping) {
+            throw std::runtime_error("Privilege batcher is stopped");
+        }
+
+        Request request;
+        request.username = username;
+        result = request.result.get_future();
+
+        queue.push_back(std::move(request));
+    }
+    cv.notify_one();
+
+    return result.get();
+}
+
+void PrivilegeBatcher::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        cv.wait(lock, [this]() { return stopping || !queue.empty(); });
+
+        if (queue.empty()) {
+            return;
+        }
+
+        // Окно набора пачки отсчитывается от первого запроса
+        auto deadline = std::chrono::steady_clock::now() + max_wait;
+        cv.wait_until(lock, deadline, [this]() { return stopping || queue.size() >= max_batch; });
+
+        std::deque<Request> batch;
+        while (!queue.empty() && batch.size() < max_batch) {
+            batch.push_back(std::move(queue.front()));
+            queue.pop_front();
+        }
+
+        lock.unlock();
+        send_batch(batch);
+        lock.lock();
+    }
+}
+
+void PrivilegeBatcher::send_batch(std::deque<Request>& batch) {
+    try {
+        // Один пользователь в пачке - один раз, даже если запросов несколько
+        nlohmann::json usernames = nlohmann::json::array();
+        std::unordered_map<std::string, PrivilegeInfo> privileges;
+
+        for (const auto& request : batch) {
+            if (privileges.emplace(request.username, PrivilegeInfo{}).second) {
+                usernames.push_back(request.username);
+            }
+        }
+
+        nlohmann::json body = { {"usernames", usernames} };
+
+        http_client client(utility::conversions::to_string_t(batch_url), client_config);
+        http_request request(methods::POST);
+        request.set_body(web::json::value::parse(utility::conversions::to_string_t(body.dump())));
+
+        http_response response = client.request(request).get();
+
+        if (response.status_code() >= 400) {
+            throw ServiceError(response.status_code());
+        }
+
+        auto response_json = nlohmann::json::parse(
+            utility::conversions::to_utf8string(response.extract_json().get().serialize()));
+
+        for (const auto& item : response_json.at("items")) {
+            auto& privilege = privileges[item.at("username").get<std::string>()];
+            privilege.balance = item.value("balance", 0);
+            privilege.status = item.value("status", "BRONZE");
+        }
+
+        for (auto& request : batch) {
+            request.result.set_value(privileges[request.username]);
+        }
+    }
+    catch (...) {
+        std::cerr << "Privilege batch of " << batch.size() << " failed" << std::endl;
+
+        for (auto& request : batch) {
+            request.result.set_exception(std::current_exception());
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <cpprest/http_client.h>
+
+// Пакетные запросы баланса в Bonus Service.
+// Параллельные запросы разных входящих запросов собираются в пачку (до
+// max_batch или max_wait с момента первого) и уходят одним
+// POST /api/v1/privilege/batch. Пока пачка в пути, следующие копятся в очереди.
+class PrivilegeBatcher {
+public:
+    struct PrivilegeInfo {
+        int balance = 0;
+        std::string status = "BRONZE";
+    };
+
+    // Bonus Service отклоняет пачки больше 1000 пользователей
+    static constexpr std::size_t max_batch_limit = 1000;
+
+    // max_batch ограничивается max_batch_limit
+    PrivilegeBatcher(const std::string& bonus_url,
+        const web::http::client::http_client_config& client_config,
+        std::size_t max_batch,
+        std::chrono::microseconds max_wait);
+    ~PrivilegeBatcher();
+
+    PrivilegeBatcher(const PrivilegeBatcher&) = delete;
+    PrivilegeBatcher& operator=(const PrivilegeBatcher&) = delete;
+
+    void start();
+    void stop();
+
+    // Блокирует вызывающий поток до ответа на пачку; бросает при ошибке Bonus Service
+    PrivilegeInfo get_privilege(const std::string& username);
+
+private:
+    struct Request {
+        std::string username;
+        std::promise<PrivilegeInfo> result;
+    };
+
+    void run();
+    void send_batch(std::deque<Request>& batch);
+
+    std::string batch_url;
+    web::http::client::http_client_config client_config;
+    std::size_t max_batch;
+    std::chrono::microseconds max_wait;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Request> queue;
+    bool stopping = false;
+
+    std::thread sender;
+};
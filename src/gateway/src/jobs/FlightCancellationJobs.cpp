@@ -0,0 +1,261 @@
+#include "FlightCancellationJobs.hpp"
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <iomanip>
+#include "../api/GatewayController.hpp"
+
+using namespace web::http;
+using namespace web::http::client;
+
+nlohmann::json FlightCancellationJobs::Progress::to_json() const {
+    nlohmann::json json = {
+        {"jobId", job_id},
+        {"flightNumber", flight_number},
+        {"state", state},
+        {"phase", phase},
+        {"ticketsCanceled", tickets_canceled},
+        {"bonusReversed", bonus_reversed},
+        {"bonusFailed", bonus_failed}
+    };
+
+    if (!error.empty()) {
+        json["error"] = error;
+    }
+
+    return json;
+}
+
+FlightCancellationJobs::FlightCancellationJobs(const std::string& flight_url,
+    const std::string& ticket_url,
+    const std::string& bonus_url,
+    const http_client_config& client_config,
+    int chunk_size,
+    std::chrono::seconds finished_ttl)
+    : flight_service_url(flight_url)
+    , ticket_service_url(ticket_url)
+    , bonus_service_url(bonus_url)
+    , client_config(client_config)
+    , chunk_size(chunk_size > 0 ? chunk_size : 500)
+    , finished_ttl(finished_ttl) {
+}
+
+FlightCancellationJobs::~FlightCancellationJobs() {
+    stopping = true;
+
+    std::vector<std::shared_ptr<Job>> all;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& [id, job] : jobs) {
+            all.push_back(job);
+        }
+    }
+
+    for (auto& job : all) {
+        if (job->worker.joinable()) {
+            job->worker.join();
+        }
+    }
+}
+
+void FlightCancellationJobs::prune_finished() {
+    auto now = std::chrono::steady_clock::now();
+
+    for (auto it = jobs.begin(); it != jobs.end();) {
+        const auto& job = it->second;
+
+        if (job->finished && now - job->finished_at >= finished_ttl) {
+            // Поток уже вышел из run() или выходит - mutex ему больше не нужен
+            if (job->worker.joinable()) {
+                job->worker.join();
+            }
+            it = jobs.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+FlightCancellationJobs::Progress FlightCancellationJobs::start(const std::string& flight_number) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    prune_finished();
+
+    auto running_it = running.find(flight_number);
+    if (running_it != running.end()) {
+        return jobs[running_it->second]->progress;
+    }
+
+    static thread_local std::mt19937_64 generator(std::random_device{}());
+
+    std::stringstream id;
+    id << std::hex << std::setfill('0') << std::setw(16) << generator();
+
+    auto job = std::make_shared<Job>();
+    job->progress.job_id = id.str();
+    job->progress.flight_number = flight_number;
+
+    jobs[job->progress.job_id] = job;
+    running[flight_number] = job->progress.job_id;
+
+    job->worker = std::thread([this, job]() { run(job); });
+
+    return job->progress;
+}
+
+std::optional<FlightCancellationJobs::Progress> FlightCancellationJobs::get(const std::string& job_id) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    prune_finished();
+
+    auto it = jobs.find(job_id);
+    if (it == jobs.end()) {
+        return std::nullopt;
+    }
+    return it->second->progress;
+}
+
+void FlightCancellationJobs::run(const std::shared_ptr<Job>& job) {
+    const std::string flight_number = job->progress.flight_number;
+    const std::string encoded_flight = utility::conversions::to_utf8string(
+        web::uri::encode_data_string(utility::conversions::to_string_t(flight_number)));
+
+    try {
+        // 0. Закрытие продажи, чтобы не появлялись новые билеты
+        post_json(flight_service_url + "/api/v1/flights/" + encoded_flight + "/close", nlohmann::json::object());
+        update(job, [](Progress& progress) { progress.phase = "CANCELING"; });
+
+        // 1. Отмена оплаченных билетов пачками
+        std::string cancel_url = ticket_service_url + "/api/v1/flights/" + encoded_flight
+            + "/tickets/cancel?limit=" + std::to_string(chunk_size);
+
+        while (!stopping) {
+            auto canceled = post_json(cancel_url, nlohmann::json::object());
+            const auto& items = canceled.at("items");
+
+            if (items.empty()) {
+                break;
+            }
+
+            nlohmann::json entries = nlohmann::json::array();
+            for (const auto& item : items) {
+                entries.push_back({ {"username", item.at("username")}, {"ticketUid", item.at("ticketUid")} });
+            }
+
+            update(job, [&](Progress& progress) { progress.tickets_canceled += static_cast<int>(items.size()); });
+
+            // Неудача здесь не страшна - пачку догонит сверка
+            try {
+                int reversed = reverse_bonuses(job, entries, false);
+                update(job, [&](Progress& progress) { progress.bonus_reversed += reversed; });
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Bonus reversal for flight " << flight_number << " deferred: " << e.what() << std::endl;
+            }
+        }
+
+        // 2. Сверка по всем отмененным билетам рейса
+        update(job, [](Progress& progress) { progress.phase = "RECONCILING"; });
+
+        std::stringstream export_body(get_text(ticket_service_url + "/api/v1/flights/" + encoded_flight
+            + "/tickets/export?status=CANCELED"));
+
+        nlohmann::json entries = nlohmann::json::array();
+        std::string line;
+
+        auto flush_entries = [&]() {
+            if (entries.empty()) {
+                return;
+            }
+            int reversed = reverse_bonuses(job, entries, true);
+            update(job, [&](Progress& progress) { progress.bonus_reversed += reversed; });
+            entries = nlohmann::json::array();
+        };
+
+        while (!stopping && std::getline(export_body, line)) {
+            if (line.empty()) {
+                continue;
+            }
+
+            auto ticket = nlohmann::json::parse(line);
+            entries.push_back({ {"username", ticket.at("username")}, {"ticketUid", ticket.at("ticketUid")} });
+
+            if (static_cast<int>(entries.size()) >= chunk_size) {
+                flush_entries();
+            }
+        }
+        flush_entries();
+
+        update(job, [this](Progress& progress) {
+            progress.state = stopping ? "FAILED" : "COMPLETED";
+            progress.phase = "DONE";
+            if (stopping) {
+                progress.error = "Gateway is stopping";
+            }
+        });
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Cancellation of flight " << flight_number << " failed: " << e.what() << std::endl;
+
+        update(job, [&](Progress& progress) {
+            progress.state = "FAILED";
+            progress.error = e.what();
+        });
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    running.erase(flight_number);
+    job->finished = true;
+    job->finished_at = std::chrono::steady_clock::now();
+}
+
+int FlightCancellationJobs::reverse_bonuses(const std::shared_ptr<Job>& job,
+    const nlohmann::json& entries, bool count_failures) {
+    auto response = post_json(bonus_service_url + "/api/v1/privilege/reverse", { {"entries", entries} });
+
+    int reversed = 0;
+    int failed = 0;
+
+    for (const auto& result : response.at("results")) {
+        const auto status = result.value("status", "");
+
+        if (status == "REVERSED") {
+            ++reversed;
+        }
+        else if (status == "INSUFFICIENT_BALANCE") {
+            ++failed;
+        }
+    }
+
+    if (count_failures && failed > 0) {
+        update(job, [&](Progress& progress) { progress.bonus_failed += failed; });
+    }
+
+    return reversed;
+}
+
+nlohmann::json FlightCancellationJobs::post_json(const std::string& url, const nlohmann::json& body) {
+    http_client client(utility::conversions::to_string_t(url), client_config);
+    http_request request(methods::POST);
+    request.set_body(web::json::value::parse(utility::conversions::to_string_t(body.dump())));
+
+    http_response response = client.request(request).get();
+
+    if (response.status_code() >= 400) {
+        throw ServiceError(response.status_code());
+    }
+
+    return nlohmann::json::parse(utility::conversions::to_utf8string(response.extract_json().get().serialize()));
+}
+
+std::string FlightCancellationJobs::get_text(const std::string& url) {
+    http_client client(utility::conversions::to_string_t(url), client_config);
+    http_response response = client.request(methods::GET).get();
+
+    if (response.status_code() >= 400) {
+        throw ServiceError(response.status_code());
+    }
+
+    return utility::conversions::to_utf8string(response.extract_string(true).get());
+}
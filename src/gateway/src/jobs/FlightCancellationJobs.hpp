@@ -0,0 +1,97 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <cpprest/http_client.h>
+
+// Фоновая отмена всех билетов рейса.
+// 0. Рейс закрывается для продажи в Flight Service: бронирование мест на нем
+//    возвращает 409, поэтому покупка через gateway больше не проходит.
+//    Покупки, успевшие забронировать место до закрытия, могут создать билет
+//    позже фазы 1 - их отменяет повторный запуск.
+// 1. Оплаченные билеты отменяются в Ticket Service пачками по chunk_size
+//    (один UPDATE на пачку), бонусные операции по ним отменяются в
+//    Bonus Service одним запросом на пачку.
+// 2. Сверка: все отмененные билеты рейса еще раз проходят через отмену
+//    бонусов. Она идемпотентна, поэтому так догоняются пачки, для которых
+//    Bonus Service не ответил, и работа, прерванная падением gateway.
+// Повторный запуск для рейса продолжает отмену с того места, где она остановилась.
+// Завершенные задачи хранятся finished_ttl, затем удаляются.
+class FlightCancellationJobs {
+public:
+    struct Progress {
+        std::string job_id;
+        std::string flight_number;
+        // RUNNING, COMPLETED, FAILED
+        std::string state = "RUNNING";
+        std::string phase = "CLOSING";
+        int tickets_canceled = 0;
+        int bonus_reversed = 0;
+        // Отмена бонусов невозможна: баланс ушел бы в минус
+        int bonus_failed = 0;
+        std::string error;
+
+        nlohmann::json to_json() const;
+    };
+
+    FlightCancellationJobs(const std::string& flight_url,
+        const std::string& ticket_url,
+        const std::string& bonus_url,
+        const web::http::client::http_client_config& client_config,
+        int chunk_size = 500,
+        std::chrono::seconds finished_ttl = std::chrono::hours(1));
+    ~FlightCancellationJobs();
+
+    FlightCancellationJobs(const FlightCancellationJobs&) = delete;
+    FlightCancellationJobs& operator=(const FlightCancellationJobs&) = delete;
+
+    // Запускает отмену рейса; если она уже идет, возвращает текущую
+    Progress start(const std::string& flight_number);
+
+    std::optional<Progress> get(const std::string& job_id);
+
+private:
+    struct Job {
+        Progress progress;
+        std::thread worker;
+        bool finished = false;
+        std::chrono::steady_clock::time_point finished_at;
+    };
+
+    void run(const std::shared_ptr<Job>& job);
+
+    // Удаляет задачи, завершенные раньше finished_ttl; вызывается под mutex
+    void prune_finished();
+
+    // Отмена бонусов по пачке билетов {username, ticketUid}; возвращает число отмененных
+    int reverse_bonuses(const std::shared_ptr<Job>& job, const nlohmann::json& entries, bool count_failures);
+
+    nlohmann::json post_json(const std::string& url, const nlohmann::json& body);
+    std::string get_text(const std::string& url);
+
+    template <typename Fn>
+    void update(const std::shared_ptr<Job>& job, Fn&& fn) {
+        std::lock_guard<std::mutex> lock(mutex);
+        fn(job->progress);
+    }
+
+    std::string flight_service_url;
+    std::string ticket_service_url;
+    std::string bonus_service_url;
+    web::http::client::http_client_config client_config;
+    int chunk_size;
+    std::chrono::seconds finished_ttl;
+
+    std::mutex mutex;
+    std::map<std::string, std::shared_ptr<Job>> jobs;
+    // Номер рейса -> идущая отмена
+    std::map<std::string, std::string> running;
+    std::atomic<bool> stopping{ false };
+};
@@ -4,8 +4,12 @@
 
 #include <iostream>
 #include <string>
+#include <cstdlib>
+#include <memory>
 #include <crow.h>
 #include "api/GatewayController.hpp"
+#include "client/PrivilegeBatcher.hpp"
+#include "jobs/FlightCancellationJobs.hpp"
 
 int main() {
     crow::SimpleApp app;
@@ -21,7 +25,39 @@ int main() {
     std::cout << "  Bonus Service: " << bonus_service_url << std::endl;
 
     try {
-        GatewayController controller(flight_service_url, ticket_service_url, bonus_service_url);
+        // GATEWAY_PRIVILEGE_BATCH=1 -   :
+        //  GATEWAY_PRIVILEGE_BATCH_MAX (  1000)  GATEWAY_PRIVILEGE_BATCH_WAIT_US 
+        std::unique_ptr<PrivilegeBatcher> privilege_batcher;
+        const char* batch_mode = std::getenv("GATEWAY_PRIVILEGE_BATCH");
+
+        if (batch_mode && std::string(batch_mode) == "1") {
+            const char* max_env = std::getenv("GATEWAY_PRIVILEGE_BATCH_MAX");
+            const char* wait_env = std::getenv("GATEWAY_PRIVILEGE_BATCH_WAIT_US");
+
+            int batch_max = max_env ? std::stoi(max_env) : 256;
+            int batch_wait_us = wait_env ? std::stoi(wait_env) : 300;
+
+            web::http::client::http_client_config batch_config;
+            batch_config.set_timeout(std::chrono::seconds(10));
+
+            privilege_batcher = std::make_unique<PrivilegeBatcher>(bonus_service_url, batch_config,
+                batch_max > 0 ? batch_max : 256,
+                std::chrono::microseconds(batch_wait_us >= 0 ? batch_wait_us : 300));
+            privilege_batcher->start();
+        }
+
+        //  :      500,    .
+        // Endpoint    X-Admin-Token,  GATEWAY_ADMIN_TOKEN
+        web::http::client::http_client_config jobs_config;
+        jobs_config.set_timeout(std::chrono::seconds(60));
+
+        FlightCancellationJobs cancellation_jobs(flight_service_url, ticket_service_url, bonus_service_url, jobs_config, 500,
+            std::chrono::hours(1));
+
+        const char* admin_token_env = std::getenv("GATEWAY_ADMIN_TOKEN");
+
+        GatewayController controller(flight_service_url, ticket_service_url, bonus_service_url,
+            privilege_batcher.get(), &cancellation_jobs, admin_token_env ? admin_token_env : "");
         controller.router(app);
 
         int port = 8080;
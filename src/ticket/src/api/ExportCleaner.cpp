@@ -0,0 +1,68 @@
+#include "ExportCleaner.hpp"
+#include <filesystem>
+#include <iostream>
+
+ExportCleaner::ExportCleaner(std::string export_dir, std::chrono::minutes max_age, std::chrono::minutes interval)
+    : export_dir(std::move(export_dir))
+    , max_age(max_age)
+    , interval(interval) {
+}
+
+ExportCleaner::~ExportCleaner() {
+    stop();
+}
+
+void ExportCleaner::start() {
+    // Файлы, оставшиеся от предыдущего запуска
+    run_once();
+    worker = std::thread([this]() { run(); });
+}
+
+void ExportCleaner::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex);
+        stopping = true;
+    }
+    stop_cv.notify_all();
+
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void ExportCleaner::run() {
+    std::unique_lock<std::mutex> lock(stop_mutex);
+
+    while (!stop_cv.wait_for(lock, interval, [this]() { return stopping; })) {
+        lock.unlock();
+        run_once();
+        lock.lock();
+    }
+}
+
+int ExportCleaner::run_once() {
+    namespace fs = std::filesystem;
+
+    std::error_code error;
+    auto now = fs::file_time_type::clock::now();
+    int removed = 0;
+
+    for (const auto& entry : fs::directory_iterator(export_dir, error)) {
+        if (entry.path().extension() != ".ndjson") {
+            continue;
+        }
+
+        std::error_code entry_error;
+        auto modified = entry.last_write_time(entry_error);
+
+        if (!entry_error && now - modified > max_age && fs::remove(entry.path(), entry_error)) {
+            ++removed;
+        }
+    }
+
+    if (error && error != std::errc::no_such_file_or_directory) {
+        std::cerr << "Export cleanup failed: " << error.message() << std::endl;
+    }
+
+    return removed;
+}
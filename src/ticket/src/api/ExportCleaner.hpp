@@ -0,0 +1,36 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Удаление временных файлов выгрузки: раз в interval удаляет из export_dir
+// файлы .ndjson старше max_age. Файл отдается клиенту после выхода из
+// обработчика, поэтому удаляется не сразу, а по возрасту.
+class ExportCleaner {
+public:
+    ExportCleaner(std::string export_dir, std::chrono::minutes max_age, std::chrono::minutes interval);
+    ~ExportCleaner();
+
+    ExportCleaner(const ExportCleaner&) = delete;
+    ExportCleaner& operator=(const ExportCleaner&) = delete;
+
+    void start();
+    void stop();
+
+    // Один проход; возвращает число удаленных файлов
+    int run_once();
+
+private:
+    void run();
+
+    std::string export_dir;
+    std::chrono::minutes max_age;
+    std::chrono::minutes interval;
+
+    std::thread worker;
+    std::mutex stop_mutex;
+    std::condition_variable stop_cv;
+    bool stopping = false;
+};
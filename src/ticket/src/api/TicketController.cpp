@@ -1,6 +1,10 @@
 #include "TicketController.hpp"
 #include <sstream>
 #include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include "../utils/UUIDGenerator.hpp"
 
 // Health check endpoint
 crow::response TicketController::health_check() {
@@ -23,6 +27,30 @@ crow::response TicketController::health_check() {
     }
 }
 
+// Счетчики выполнений prepared statements
+crow::response TicketController::get_statement_stats() {
+    nlohmann::json response = nlohmann::json::object();
+
+    for (const auto& [name, executions] : ticket_repository.get_statement_stats()) {
+        response[name] = executions;
+    }
+
+    crow::response res(200, response.dump());
+    res.set_header("Content-Type", "application/json");
+    return res;
+}
+
+// Попадания и промахи кэша билетов
+crow::response TicketController::get_cache_stats() {
+    nlohmann::json response = ticket_cache
+        ? ticket_cache->get_stats()
+        : nlohmann::json{ {"enabled", false} };
+
+    crow::response res(200, response.dump());
+    res.set_header("Content-Type", "application/json");
+    return res;
+}
+
 // Создание массива ошибок
 crow::response TicketController::create_error_array_response(const std::string err_type = "both") {
     
@@ -96,7 +124,7 @@ crow::response TicketController::validate_ticket_creation(const nlohmann::json&
     return crow::response(200);
 }
 
-// GET /api/v1/tickets - получить все билеты пользователя
+// GET /api/v1/tickets?page= &size= &cursor= &status= - билеты пользователя, новые первыми
 crow::response TicketController::get_user_tickets(const crow::request& req) {
     try {
         std::string username = req.get_header_value("X-User-Name");
@@ -105,18 +133,76 @@ crow::response TicketController::get_user_tickets(const crow::request& req) {
             return create_error_response(404, "Билеты не найдены");
         }
         
-        auto tickets = ticket_repository.get_tickets_by_username(username);
-        
-        nlohmann::json response = nlohmann::json::array();
-        
-        for (const auto& ticket : tickets) {
-            response.push_back(ticket.to_api_json());
+        std::optional<std::string> status;
+        if (req.url_params.get("status")) {
+            status = std::string(req.url_params.get("status"));
+
+            if (*status != "PAID" && *status != "CANCELED") {
+                return create_error_response(400, "Invalid status: " + *status);
+            }
         }
-        
+
+        const char* page_param = req.url_params.get("page");
+        const char* size_param = req.url_params.get("size");
+        const char* cursor_param = req.url_params.get("cursor");
+
+        // Без параметров пагинации - прежний ответ массивом
+        if (!page_param && !size_param && !cursor_param) {
+            auto tickets = ticket_repository.get_tickets_by_username(username, status);
+
+            nlohmann::json response = nlohmann::json::array();
+
+            for (const auto& ticket : tickets) {
+                response.push_back(ticket.to_api_json());
+            }
+
+            crow::response res(200, response.dump());
+            res.set_header("Content-Type", "application/json");
+            return res;
+        }
+
+        TicketRepository::TicketPageQuery query;
+        query.username = username;
+        query.status = status;
+
+        if (page_param) {
+            query.page = std::max(1, std::stoi(page_param));
+        }
+
+        if (size_param) {
+            query.page_size = std::clamp(std::stoi(size_param), 1, 100);
+        }
+
+        if (cursor_param) {
+            query.cursor = cursor_param;
+        }
+
+        auto page = ticket_repository.get_tickets_page(query);
+
+        nlohmann::json items = nlohmann::json::array();
+
+        for (const auto& ticket : page.tickets) {
+            items.push_back(ticket.to_api_json());
+        }
+
+        nlohmann::json response = {
+            {"items", items},
+            {"page", query.page},
+            {"pageSize", query.page_size},
+            {"nextCursor", page.next_cursor.empty() ? nlohmann::json() : nlohmann::json(page.next_cursor)}
+        };
+
         crow::response res(200, response.dump());
         res.set_header("Content-Type", "application/json");
         return res;
         
+    } catch (const std::invalid_argument& e) {
+        return create_error_response(400, e.what());
+
+    } catch (const std::out_of_range& e) {
+        // std::stoi на слишком большом page/size
+        return create_error_response(400, "Page parameters are out of range");
+
     } catch (const std::exception& e) {
         return crow::response(500);
     }
@@ -140,7 +226,7 @@ crow::response TicketController::get_ticket_by_uid(const crow::request& req, con
 
 
 
-        auto ticket_opt = ticket_repository.get_ticket_by_uid(ticket_uid);
+        auto ticket_opt = ticket_repository.get_ticket_by_uid(ticket_uid, username);
         
 
         if (!ticket_opt) {
@@ -185,7 +271,9 @@ crow::response TicketController::create_ticket(const crow::request& req) {
         std::string flight_number = json_body["flightNumber"];
         std::string status = "PAID";
         
-        Ticket ticket = ticket_repository.create_ticket(username, flight_number, price, status);
+        Ticket ticket = batch_writer
+            ? batch_writer->create_ticket(username, flight_number, price, status)
+            : ticket_repository.create_ticket(username, flight_number, price, status);
         nlohmann::json response = ticket.to_api_json();
         
         res = crow::response(200, response.dump());
@@ -206,23 +294,113 @@ crow::response TicketController::canceled_ticket(const crow::request& req, const
             return create_error_response(404, "Билет не найден");
         }
 
-        if (!ticket_repository.ticket_belongs_to_user(ticket_uid, username)) {
+        auto cancel = ticket_repository.cancel_ticket(ticket_uid, username);
+
+        if (cancel.status == TicketRepository::CancelStatus::NotFound) {
             return create_error_response(404, "Билет не найден");
         }
-        
-        bool updated = ticket_repository.update_ticket_status(ticket_uid, "CANCELED");
-        
-        if (!updated) {
-            return create_error_response(404, "Билет не найден");
+
+        if (cancel.status == TicketRepository::CancelStatus::AlreadyCanceled) {
+            return create_error_response(409, "Билет уже возвращен");
         }
-        
-        return crow::response(204);
+
+        // Состояние билета до отмены
+        crow::response res(200, cancel.ticket->to_api_json().dump());
+        res.set_header("Content-Type", "application/json");
+        return res;
         
     } catch (const std::exception& e) {
         return crow::response(500);
     }
 }
 
+// GET /api/v1/flights/{flightNumber}/tickets/export?status=
+// Строки из COPY пишутся во временный файл, который Crow отдает с диска
+// частями: память не растет с числом билетов.
+crow::response TicketController::export_flight_tickets(const crow::request& req, const std::string& flight_number) {
+    try {
+        std::optional<std::string> status;
+        if (req.url_params.get("status")) {
+            status = std::string(req.url_params.get("status"));
+
+            if (*status != "PAID" && *status != "CANCELED") {
+                return create_error_response(400, "Invalid status: " + *status);
+            }
+        }
+
+        std::filesystem::create_directories(export_dir);
+
+        auto path = std::filesystem::path(export_dir) / (UUIDGenerator::generate_uuid_v4() + ".ndjson");
+        std::size_t rows = 0;
+
+        {
+            std::ofstream out(path, std::ios::binary);
+            if (!out) {
+                throw std::runtime_error("Cannot create export file " + path.string());
+            }
+
+            rows = ticket_repository.export_flight_tickets(flight_number, status, out);
+
+            out.flush();
+            if (!out) {
+                throw std::runtime_error("Cannot write export file " + path.string());
+            }
+        }
+
+        crow::response res;
+        res.set_static_file_info_unsafe(path.string());
+        res.set_header("Content-Type", "application/x-ndjson");
+        res.set_header("X-Export-Rows", std::to_string(rows));
+        return res;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error exporting tickets of flight " << flight_number << ": " << e.what() << std::endl;
+        return create_error_response(500, "Export failed");
+    }
+}
+
+// POST /api/v1/flights/{flightNumber}/tickets/cancel?limit=N - отмена оплаченных билетов рейса.
+// За вызов отменяется не больше limit билетов; пустой items - отменять больше нечего.
+crow::response TicketController::cancel_flight_tickets(const crow::request& req, const std::string& flight_number) {
+    try {
+        int limit = 500;
+
+        if (const char* limit_param = req.url_params.get("limit")) {
+            limit = std::clamp(std::stoi(limit_param), 1, 5000);
+        }
+
+        auto tickets = ticket_repository.cancel_flight_tickets(flight_number, limit);
+
+        nlohmann::json items = nlohmann::json::array();
+
+        for (const auto& ticket : tickets) {
+            nlohmann::json item = ticket.to_api_json();
+            item["username"] = ticket.username;
+            items.push_back(std::move(item));
+        }
+
+        nlohmann::json response = {
+            {"flightNumber", flight_number},
+            {"count", tickets.size()},
+            {"items", items}
+        };
+
+        crow::response res(200, response.dump());
+        res.set_header("Content-Type", "application/json");
+        return res;
+
+    } catch (const std::invalid_argument& e) {
+        return create_error_response(400, "Invalid limit");
+
+    } catch (const std::out_of_range& e) {
+        return create_error_response(400, "Invalid limit");
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error canceling tickets of flight " << flight_number << ": " << e.what() << std::endl;
+        return crow::response(500);
+    }
+}
+
 // Роутер
 void TicketController::router(crow::SimpleApp& app) {
     // health check
@@ -231,6 +409,18 @@ void TicketController::router(crow::SimpleApp& app) {
     ([this]() {
         return this->health_check();
     });
+
+    CROW_ROUTE(app, "/manage/statements")
+        .methods("GET"_method)
+    ([this]() {
+        return this->get_statement_stats();
+    });
+
+    CROW_ROUTE(app, "/manage/cache")
+        .methods("GET"_method)
+    ([this]() {
+        return this->get_cache_stats();
+    });
     
     // GET /api/v1/tickets - все билеты пользователя
     CROW_ROUTE(app, "/api/v1/tickets")
@@ -253,6 +443,20 @@ void TicketController::router(crow::SimpleApp& app) {
         return this->get_ticket_by_uid(req, ticket_uid);
     });
     
+    // GET /api/v1/flights/{flightNumber}/tickets/export - выгрузка билетов рейса
+    CROW_ROUTE(app, "/api/v1/flights/<string>/tickets/export")
+        .methods("GET"_method)
+    ([this](const crow::request& req, const std::string& flight_number) {
+        return this->export_flight_tickets(req, flight_number);
+    });
+
+    // POST /api/v1/flights/{flightNumber}/tickets/cancel - отмена билетов рейса (внутренний endpoint)
+    CROW_ROUTE(app, "/api/v1/flights/<string>/tickets/cancel")
+        .methods("POST"_method)
+    ([this](const crow::request& req, const std::string& flight_number) {
+        return this->cancel_flight_tickets(req, flight_number);
+    });
+
     // DELETE /api/v1/tickets/{ticketUid} - возврат
     CROW_ROUTE(app, "/api/v1/tickets/<string>")
         .methods("DELETE"_method)
@@ -2,13 +2,30 @@
 #include <crow.h>
 #include <nlohmann/json.hpp>
 #include "../database/TicketRepository.hpp"
+#include "../database/TicketBatchWriter.hpp"
 
 class TicketController {
 private:
     TicketRepository& ticket_repository;
+
+    // Групповая запись билетов; nullptr - каждый билет своей транзакцией
+    TicketBatchWriter* batch_writer;
+
+    // Для метрик кэша; nullptr - кэш выключен
+    TicketCache* ticket_cache;
+
+    // Каталог временных файлов выгрузки; старые файлы удаляет ExportCleaner
+    std::string export_dir;
     
 public:
-    explicit TicketController(TicketRepository& repo) : ticket_repository(repo) {}
+    explicit TicketController(TicketRepository& repo,
+        TicketBatchWriter* writer = nullptr,
+        TicketCache* cache = nullptr,
+        const std::string& export_dir = "/tmp/ticket-exports")
+        : ticket_repository(repo)
+        , batch_writer(writer)
+        , ticket_cache(cache)
+        , export_dir(export_dir) {}
     
     // Роутер
     void router(crow::SimpleApp& app);
@@ -16,6 +33,8 @@ public:
 private:
     // Обработчики запросов
     crow::response health_check();
+    crow::response get_statement_stats();
+    crow::response get_cache_stats();
     
     // Получить все билеты пользователя
     crow::response get_user_tickets(const crow::request& req);
@@ -29,6 +48,10 @@ private:
     // Возврат билета
     crow::response canceled_ticket(const crow::request& req, const std::string& ticket_uid);
 
+    // Выгрузка билетов рейса в NDJSON
+    crow::response export_flight_tickets(const crow::request& req, const std::string& flight_number);
+    crow::response cancel_flight_tickets(const crow::request& req, const std::string& flight_number);
+
 
 
     crow::response validate_ticket_creation(const nlohmann::json& json_body);
@@ -0,0 +1,137 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+// LRU-кэш, разбитый на сегменты со своими mutex.
+// Каждое изменение сегмента увеличивает его версию: заполнение после чтения
+// из БД (put_if_version) не перетирает запись, сделанную за время чтения.
+template <typename Key, typename Value, std::size_t ShardCount = 16>
+class ShardedLru {
+public:
+    explicit ShardedLru(std::size_t capacity)
+        : shard_capacity(capacity / ShardCount > 0 ? capacity / ShardCount : 1) {
+    }
+
+    std::optional<Value> get(const Key& key) {
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            misses.fetch_add(1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        hits.fetch_add(1, std::memory_order_relaxed);
+        return it->second->second;
+    }
+
+    std::uint64_t version(const Key& key) {
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.version;
+    }
+
+    // Кладет значение, если сегмент не менялся с момента version()
+    bool put_if_version(const Key& key, Value value, std::uint64_t expected_version) {
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        if (shard.version != expected_version) {
+            return false;
+        }
+
+        insert(shard, key, std::move(value));
+        return true;
+    }
+
+    void put(const Key& key, Value value) {
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        ++shard.version;
+        insert(shard, key, std::move(value));
+    }
+
+    // Изменяет значение на месте, если ключ есть в кэше
+    void update(const Key& key, const std::function<void(Value&)>& apply) {
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        ++shard.version;
+
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            apply(it->second->second);
+        }
+    }
+
+    void erase(const Key& key) {
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        ++shard.version;
+
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            shard.entries.erase(it->second);
+            shard.index.erase(it);
+        }
+    }
+
+    std::size_t size() {
+        std::size_t total = 0;
+        for (auto& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            total += shard.index.size();
+        }
+        return total;
+    }
+
+    std::uint64_t get_hits() const { return hits.load(std::memory_order_relaxed); }
+    std::uint64_t get_misses() const { return misses.load(std::memory_order_relaxed); }
+
+private:
+    struct Shard {
+        std::mutex mutex;
+        std::list<std::pair<Key, Value>> entries;
+        std::unordered_map<Key, typename std::list<std::pair<Key, Value>>::iterator> index;
+        std::uint64_t version = 0;
+    };
+
+    Shard& shard_for(const Key& key) {
+        return shards[std::hash<Key>{}(key) % ShardCount];
+    }
+
+    void insert(Shard& shard, const Key& key, Value value) {
+        auto it = shard.index.find(key);
+
+        if (it != shard.index.end()) {
+            it->second->second = std::move(value);
+            shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+            return;
+        }
+
+        shard.entries.emplace_front(key, std::move(value));
+        shard.index.emplace(key, shard.entries.begin());
+
+        if (shard.index.size() > shard_capacity) {
+            shard.index.erase(shard.entries.back().first);
+            shard.entries.pop_back();
+        }
+    }
+
+    std::size_t shard_capacity;
+    std::array<Shard, ShardCount> shards;
+
+    std::atomic<std::uint64_t> hits{ 0 };
+    std::atomic<std::uint64_t> misses{ 0 };
+};
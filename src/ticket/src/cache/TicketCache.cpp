@@ -0,0 +1,84 @@
+#include "TicketCache.hpp"
+#include <algorithm>
+
+TicketCache::TicketCache(std::size_t ticket_capacity, std::size_t user_capacity, std::size_t max_user_tickets)
+    : tickets(ticket_capacity)
+    , user_tickets(user_capacity)
+    , max_user_tickets(max_user_tickets) {
+}
+
+std::optional<Ticket> TicketCache::get_ticket(const Uuid& ticket_uid) {
+    return tickets.get(ticket_uid);
+}
+
+std::optional<std::vector<Ticket>> TicketCache::get_user_tickets(const std::string& username) {
+    return user_tickets.get(username);
+}
+
+std::uint64_t TicketCache::ticket_version(const Uuid& ticket_uid) {
+    return tickets.version(ticket_uid);
+}
+
+std::uint64_t TicketCache::user_version(const std::string& username) {
+    return user_tickets.version(username);
+}
+
+void TicketCache::fill_ticket(const Ticket& ticket, std::uint64_t version) {
+    tickets.put_if_version(ticket.ticket_uid, ticket, version);
+}
+
+void TicketCache::fill_user_tickets(const std::string& username, const std::vector<Ticket>& list, std::uint64_t version) {
+    if (list.size() > max_user_tickets) {
+        return;
+    }
+
+    user_tickets.put_if_version(username, list, version);
+}
+
+void TicketCache::on_ticket_created(const Ticket& ticket) {
+    tickets.put(ticket.ticket_uid, ticket);
+
+    // Новые билеты - в начале списка
+    bool too_long = false;
+    user_tickets.update(ticket.username, [this, &ticket, &too_long](std::vector<Ticket>& list) {
+        list.insert(list.begin(), ticket);
+        too_long = list.size() > max_user_tickets;
+    });
+
+    if (too_long) {
+        user_tickets.erase(ticket.username);
+    }
+}
+
+void TicketCache::on_ticket_updated(const Ticket& ticket) {
+    tickets.put(ticket.ticket_uid, ticket);
+
+    user_tickets.update(ticket.username, [&ticket](std::vector<Ticket>& list) {
+        auto it = std::find_if(list.begin(), list.end(),
+            [&ticket](const Ticket& cached) { return cached.ticket_uid == ticket.ticket_uid; });
+
+        if (it != list.end()) {
+            *it = ticket;
+        }
+    });
+}
+
+nlohmann::json TicketCache::get_stats() {
+    auto describe = [](auto& cache) {
+        std::uint64_t hits = cache.get_hits();
+        std::uint64_t misses = cache.get_misses();
+        std::uint64_t total = hits + misses;
+
+        return nlohmann::json{
+            {"entries", cache.size()},
+            {"hits", hits},
+            {"misses", misses},
+            {"hitRate", total > 0 ? static_cast<double>(hits) / static_cast<double>(total) : 0.0}
+        };
+    };
+
+    return {
+        {"tickets", describe(tickets)},
+        {"users", describe(user_tickets)}
+    };
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "ShardedLru.hpp"
+#include "../models/Ticket.hpp"
+
+// Кэш билетов в памяти сервиса: по ticket_uid и полные списки по username.
+// Заполняется при чтении, а все записи репозитория обновляют его сразу
+// после commit (write-through). Списки длиннее max_user_tickets не кэшируются.
+class TicketCache {
+public:
+    TicketCache(std::size_t ticket_capacity, std::size_t user_capacity, std::size_t max_user_tickets = 256);
+
+    std::optional<Ticket> get_ticket(const Uuid& ticket_uid);
+    std::optional<std::vector<Ticket>> get_user_tickets(const std::string& username);
+
+    // Версии для заполнения кэша результатом чтения из БД
+    std::uint64_t ticket_version(const Uuid& ticket_uid);
+    std::uint64_t user_version(const std::string& username);
+
+    void fill_ticket(const Ticket& ticket, std::uint64_t version);
+    void fill_user_tickets(const std::string& username, const std::vector<Ticket>& tickets, std::uint64_t version);
+
+    // Write-through после commit
+    void on_ticket_created(const Ticket& ticket);
+    void on_ticket_updated(const Ticket& ticket);
+
+    nlohmann::json get_stats();
+
+private:
+    ShardedLru<Uuid, Ticket> tickets;
+    ShardedLru<std::string, std::vector<Ticket>> user_tickets;
+    std::size_t max_user_tickets;
+};
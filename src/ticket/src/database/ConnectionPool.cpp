@@ -0,0 +1,103 @@
+#include "ConnectionPool.hpp"
+#include <stdexcept>
+#include <iostream>
+
+ConnectionPool::Lease::Lease(ConnectionPool& pool, std::unique_ptr<pqxx::connection> connection)
+    : pool(&pool)
+    , connection(std::move(connection)) {
+}
+
+ConnectionPool::Lease::Lease(Lease&& other) noexcept
+    : pool(other.pool)
+    , connection(std::move(other.connection)) {
+}
+
+ConnectionPool::Lease::~Lease() {
+    if (connection) {
+        pool->release(std::move(connection));
+    }
+}
+
+ConnectionPool::ConnectionPool(const std::string& connection_string, std::size_t capacity,
+    Initializer initializer)
+    : connection_string(connection_string)
+    , capacity(capacity == 0 ? 1 : capacity)
+    , initializer(std::move(initializer)) {
+
+    // Открываем все соединения сразу, чтобы ошибки конфигурации были видны на старте
+    for (std::size_t i = 0; i < this->capacity; ++i) {
+        idle.push_back(open_connection());
+        ++open_count;
+    }
+}
+
+std::unique_ptr<pqxx::connection> ConnectionPool::open_connection() {
+    auto connection = std::make_unique<pqxx::connection>(connection_string);
+
+    if (initializer) {
+        initializer(*connection);
+    }
+
+    return connection;
+}
+
+ConnectionPool::Lease ConnectionPool::acquire() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    available.wait(lock, [this]() {
+        return !idle.empty() || open_count < capacity;
+    });
+
+    if (!idle.empty()) {
+        auto connection = std::move(idle.back());
+        idle.pop_back();
+        return Lease(*this, std::move(connection));
+    }
+
+    // Соединение было потеряно ранее - открываем замену вне блокировки
+    ++open_count;
+    lock.unlock();
+
+    try {
+        return Lease(*this, open_connection());
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Connection pool: failed to reopen connection: " << e.what() << std::endl;
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            --open_count;
+        }
+        available.notify_one();
+        throw;
+    }
+}
+
+void ConnectionPool::release(std::unique_ptr<pqxx::connection> connection) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (connection->is_open()) {
+            idle.push_back(std::move(connection));
+        }
+        else {
+            --open_count;
+        }
+    }
+    available.notify_one();
+}
+
+bool ConnectionPool::is_connected() const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (open_count == 0) {
+        return false;
+    }
+
+    for (const auto& connection : idle) {
+        if (!connection->is_open()) {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,46 @@
+#include "Migrations.hpp"
+
+std::vector<Migration> ticket_migrations() {
+    return {
+        { 1, "create ticket table", {
+            R"(
+                CREATE TABLE IF NOT EXISTS ticket
+                (
+                    id            SERIAL PRIMARY KEY,
+                    ticket_uid    uuid UNIQUE NOT NULL,
+                    username      VARCHAR(80) NOT NULL,
+                    flight_number VARCHAR(20) NOT NULL,
+                    price         INT         NOT NULL,
+                    status        VARCHAR(20) NOT NULL
+                        CHECK (status IN ('PAID', 'CANCELED'))
+                )
+            )",
+            // Тестовые данные - только в пустую базу
+            R"(
+                INSERT INTO ticket (ticket_uid, username, flight_number, price, status)
+                SELECT '049161bb-badd-4fa8-9d90-87c9a82b0668', 'Test Max', 'AFL031', 1500, 'PAID'
+                WHERE NOT EXISTS (SELECT 1 FROM ticket)
+            )"
+        } },
+        { 2, "add ticket username index", {
+            // get_tickets_by_username
+            "CREATE INDEX IF NOT EXISTS idx_ticket_username ON ticket (username)"
+        } },
+        { 3, "add ticket purchase time and covering listing index", {
+            // now() вычисляется один раз - таблица не переписывается
+            "ALTER TABLE ticket ADD COLUMN IF NOT EXISTS purchased_at TIMESTAMP WITH TIME ZONE NOT NULL DEFAULT now()",
+            // Список билетов пользователя: WHERE username ORDER BY purchased_at DESC, id DESC
+            R"(
+                CREATE INDEX IF NOT EXISTS idx_ticket_username_purchased
+                ON ticket (username, purchased_at DESC, id DESC)
+                INCLUDE (ticket_uid, flight_number, price, status)
+            )",
+            // Покрывается новым индексом
+            "DROP INDEX IF EXISTS idx_ticket_username"
+        } },
+        { 4, "add flight tickets index", {
+            // Отмена и выгрузка билетов рейса: WHERE flight_number AND status ORDER BY id
+            "CREATE INDEX IF NOT EXISTS idx_ticket_flight_status ON ticket (flight_number, status, id)"
+        } }
+    };
+}
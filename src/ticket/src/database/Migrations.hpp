@@ -0,0 +1,6 @@
+#pragma once
+#include <vector>
+#include "MigrationRunner.hpp"
+
+// Миграции схемы базы данных tickets по возрастанию версии
+std::vector<Migration> ticket_migrations();
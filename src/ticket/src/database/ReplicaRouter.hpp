@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "ConnectionPool.hpp"
+
+// Маршрутизация чтений на реплики.
+// Фоновый поток опрашивает отставание каждой реплики; для чтения выбирается
+// реплика с отставанием не больше max_lag (по кругу). Пользователь, который
+// недавно писал, читает с primary в течение read_your_writes_window.
+class ReplicaRouter {
+public:
+    struct Options {
+        std::vector<std::string> connection_strings;
+        std::size_t pool_size = 4;
+        std::chrono::milliseconds max_lag{ 1000 };
+        std::chrono::milliseconds read_your_writes_window{ 5000 };
+        std::chrono::milliseconds poll_interval{ 1000 };
+    };
+
+    ReplicaRouter(Options options, ConnectionPool::Initializer initializer);
+    ~ReplicaRouter();
+
+    ReplicaRouter(const ReplicaRouter&) = delete;
+    ReplicaRouter& operator=(const ReplicaRouter&) = delete;
+
+    void start();
+    void stop();
+
+    // Пул реплики для чтения; nullptr - читать с primary.
+    // Пустой username - чтение без привязки к пользователю.
+    ConnectionPool* pool_for_read(const std::string& username);
+
+    // Запись пользователя закоммичена на primary
+    void record_write(const std::string& username);
+
+    // Ошибка соединения с репликой - исключить до следующего опроса
+    void report_failure(ConnectionPool* replica_pool);
+
+private:
+    struct Replica {
+        std::string connection_string;
+        // Владеет пулом только поток опроса; остальные читают pool
+        std::unique_ptr<ConnectionPool> owned_pool;
+        std::atomic<ConnectionPool*> pool{ nullptr };
+        std::atomic<bool> healthy{ false };
+        std::atomic<long long> lag_ms{ 0 };
+    };
+
+    void run();
+    void poll();
+
+    Options options;
+    ConnectionPool::Initializer initializer;
+
+    std::vector<std::unique_ptr<Replica>> replicas;
+    std::atomic<std::size_t> next_replica{ 0 };
+
+    std::mutex writes_mutex;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> recent_writes;
+
+    std::thread poller;
+    std::mutex stop_mutex;
+    std::condition_variable stop_cv;
+    bool stopping = false;
+};
@@ -0,0 +1,112 @@
+#include "TicketBatchWriter.hpp"
+#include <iostream>
+#include <stdexcept>
+
+TicketBatchWriter::TicketBatchWriter(TicketRepository& repo, std::size_t max_batch, std::chrono::microseconds max_wait)
+    : ticket_repository(repo)
+    , max_batch(max_batch > 0 ? max_batch : 1)
+    , max_wait(max_wait) {
+}
+
+TicketBatchWriter::~TicketBatchWriter() {
+    stop();
+}
+
+void TicketBatchWriter::start() {
+    writer = std::thread([this]() { run(); });
+}
+
+void TicketBatchWriter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
+
+Ticket TicketBatchWriter::create_ticket(const std::string& username,
+                                        const std::string& flight_number,
+                                        int price,
+                                        const std::string& status) {
+    std::future<Ticket> result;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (stopping) {
+            throw std::runtime_error("Ticket batch writer is stopped");
+        }
+
+        Request request;
+        request.ticket = { username, flight_number, price, status };
+        result = request.result.get_future();
+
+        queue.push_back(std::move(request));
+    }
+    cv.notify_one();
+
+    return result.get();
+}
+
+void TicketBatchWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        cv.wait(lock, [this]() { return stopping || !queue.empty(); });
+
+        if (queue.empty()) {
+            return;
+        }
+
+        // Окно набора пачки отсчитывается от первого запроса
+        auto deadline = std::chrono::steady_clock::now() + max_wait;
+        cv.wait_until(lock, deadline, [this]() { return stopping || queue.size() >= max_batch; });
+
+        std::deque<Request> batch;
+        while (!queue.empty() && batch.size() < max_batch) {
+            batch.push_back(std::move(queue.front()));
+            queue.pop_front();
+        }
+
+        lock.unlock();
+        write_batch(batch);
+        lock.lock();
+    }
+}
+
+void TicketBatchWriter::write_batch(std::deque<Request>& batch) {
+    std::vector<TicketRepository::NewTicket> tickets;
+    tickets.reserve(batch.size());
+
+    for (const auto& request : batch) {
+        tickets.push_back(request.ticket);
+    }
+
+    try {
+        auto created = ticket_repository.create_tickets(tickets);
+
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            batch[i].result.set_value(std::move(created[i]));
+        }
+        return;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Ticket batch of " << batch.size() << " failed, writing one by one: " << e.what() << std::endl;
+    }
+
+    // Ошибочная строка не должна ронять остальные билеты пачки
+    for (auto& request : batch) {
+        try {
+            const auto& ticket = request.ticket;
+            request.result.set_value(ticket_repository.create_ticket(
+                ticket.username, ticket.flight_number, ticket.price, ticket.status));
+        }
+        catch (...) {
+            request.result.set_exception(std::current_exception());
+        }
+    }
+}
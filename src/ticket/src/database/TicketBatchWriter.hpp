@@ -0,0 +1,52 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "TicketRepository.hpp"
+
+// Групповая запись билетов.
+// Параллельные запросы на создание собираются в пачку (до max_batch штук или
+// max_wait с момента первого запроса) и вставляются одним INSERT в одной
+// транзакции - один commit на пачку вместо commit на каждый билет.
+// Пока пачка пишется, следующие запросы копятся в очереди.
+class TicketBatchWriter {
+public:
+    TicketBatchWriter(TicketRepository& repo, std::size_t max_batch, std::chrono::microseconds max_wait);
+    ~TicketBatchWriter();
+
+    TicketBatchWriter(const TicketBatchWriter&) = delete;
+    TicketBatchWriter& operator=(const TicketBatchWriter&) = delete;
+
+    void start();
+    void stop();
+
+    // Блокирует вызывающий поток до записи пачки, в которую попал билет
+    Ticket create_ticket(const std::string& username,
+                         const std::string& flight_number,
+                         int price,
+                         const std::string& status);
+
+private:
+    struct Request {
+        TicketRepository::NewTicket ticket;
+        std::promise<Ticket> result;
+    };
+
+    void run();
+    void write_batch(std::deque<Request>& batch);
+
+    TicketRepository& ticket_repository;
+    std::size_t max_batch;
+    std::chrono::microseconds max_wait;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Request> queue;
+    bool stopping = false;
+
+    std::thread writer;
+};
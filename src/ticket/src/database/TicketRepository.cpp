@@ -2,59 +2,128 @@
 #include "../utils/UUIDGenerator.hpp"
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
+#include <unordered_map>
+
+TicketRepository::TicketRepository(const std::string& connection_string, std::size_t pool_size, TicketCache* cache,
+                                   const ReplicaRouter::Options& replica_options)
+    : cache(cache) {
+    // Схема создается миграциями (см. Migrations) до создания репозитория
+    register_statements();
 
-TicketRepository::TicketRepository(const std::string& connection_string) {
     try {
-        connection = std::make_unique<pqxx::connection>(connection_string);
+        pool = std::make_unique<ConnectionPool>(connection_string, pool_size,
+            [this](pqxx::connection& conn) { statements.prepare(conn); });
         std::cout << "TicketService: Connected to database successfully" << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "TicketService: Database connection failed: " << e.what() << std::endl;
         throw;
     }
 
-    try {
-        pqxx::work txn(*connection);
+    if (!replica_options.connection_strings.empty()) {
+        replicas = std::make_unique<ReplicaRouter>(replica_options,
+            [this](pqxx::connection& conn) { statements.prepare(conn); });
+        replicas->start();
+        std::cout << "TicketService: Read replicas: " << replica_options.connection_strings.size() << std::endl;
+    }
+}
 
-        std::string sql = "";
+TicketRepository::~TicketRepository() {
+    if (replicas) {
+        replicas->stop();
+    }
+}
 
-        auto result = txn.exec("SELECT count(*) FROM information_schema.tables WHERE table_schema = 'public'");
-        sql.clear();
+void TicketRepository::register_statements() {
+    statements.add("create_ticket", R"(
+            INSERT INTO ticket (ticket_uid, username, flight_number, price, status)
+            VALUES ($1, $2, $3, $4, $5)
+            RETURNING id, ticket_uid, username, flight_number, price, status
+        )");
 
-        if (result[0][0].as<int>() == 0) {
-            sql.clear();
-            sql = "CREATE TABLE ticket\
-                (\
-                    id            SERIAL PRIMARY KEY,\
-                    ticket_uid    uuid UNIQUE NOT NULL,\
-                    username      VARCHAR(80) NOT NULL,\
-                    flight_number VARCHAR(20) NOT NULL,\
-                    price         INT         NOT NULL,\
-                    status        VARCHAR(20) NOT NULL\
-                    CHECK(status IN('PAID', 'CANCELED'))\
-                    );";
-            result = txn.exec(sql);
+    statements.add("create_tickets", R"(
+            INSERT INTO ticket (ticket_uid, username, flight_number, price, status)
+            SELECT * FROM unnest($1::uuid[], $2::varchar[], $3::varchar[], $4::int[], $5::varchar[])
+            RETURNING id, ticket_uid, username, flight_number, price, status
+        )");
 
-            sql.clear();
-            sql = "INSERT INTO ticket (ticket_uid, username, flight_number, price, status) VALUES ('049161bb-badd-4fa8-9d90-87c9a82b0668', 'Test Max', 'AFL031', '1500', 'PAID');";
-            result = txn.exec(sql);
-        }
+    statements.add("get_ticket_by_uid", R"(
+            SELECT id, ticket_uid, username, flight_number, price, status
+            FROM ticket
+            WHERE ticket_uid = $1
+        )");
 
-        txn.commit();
-    }
-    catch (const std::exception& e) {
-        std::cerr << "Create table database error: " << e.what() << std::endl;
-    }
+    statements.add("get_tickets_by_username", R"(
+            SELECT id, ticket_uid, username, flight_number, price, status
+            FROM ticket
+            WHERE username = $1
+              AND ($2::varchar IS NULL OR status = $2)
+            ORDER BY purchased_at DESC, id DESC
+        )");
 
-}
+    // Страницы списка билетов; LIMIT на одну строку больше размера страницы,
+    // чтобы узнать, есть ли следующая
+    statements.add("get_tickets_page", R"(
+            SELECT id, ticket_uid, username, flight_number, price, status, purchased_at
+            FROM ticket
+            WHERE username = $1
+              AND ($2::varchar IS NULL OR status = $2)
+            ORDER BY purchased_at DESC, id DESC
+            LIMIT $3 OFFSET $4
+        )");
 
-TicketRepository::~TicketRepository() {}
+    statements.add("get_tickets_after_cursor", R"(
+            SELECT id, ticket_uid, username, flight_number, price, status, purchased_at
+            FROM ticket
+            WHERE username = $1
+              AND ($2::varchar IS NULL OR status = $2)
+              AND (purchased_at, id) < ($3::timestamptz, $4)
+            ORDER BY purchased_at DESC, id DESC
+            LIMIT $5
+        )");
+
+    // status в RETURNING - состояние до отмены
+    statements.add("cancel_ticket", R"(
+            UPDATE ticket
+            SET status = 'CANCELED'
+            WHERE ticket_uid = $1 AND username = $2 AND status = 'PAID'
+            RETURNING id, ticket_uid, username, flight_number, price, 'PAID'::varchar AS status
+        )");
+
+    // FOR UPDATE ждет билеты, которые сейчас возвращаются или создаются:
+    // пустой результат означает, что оплаченных билетов рейса не осталось
+    // (с SKIP LOCKED он означал бы и "все оставшиеся заблокированы")
+    statements.add("cancel_flight_tickets", R"(
+            UPDATE ticket
+            SET status = 'CANCELED'
+            WHERE id IN (
+                SELECT id FROM ticket
+                WHERE flight_number = $1 AND status = 'PAID'
+                ORDER BY id
+                LIMIT $2
+                FOR UPDATE
+            )
+            RETURNING id, ticket_uid, username, flight_number, price, status
+        )");
+
+    statements.add("update_ticket_status", R"(
+            UPDATE ticket
+            SET status = $1
+            WHERE ticket_uid = $2
+            RETURNING id, ticket_uid, username, flight_number, price, status
+        )");
+}
 
 bool TicketRepository::connect() {
-    return connection && connection->is_open();
+    return pool && pool->is_connected();
 }
 
 bool TicketRepository::is_connected() const {
-    return connection && connection->is_open();
+    return pool && pool->is_connected();
+}
+
+std::vector<std::pair<std::string, std::uint64_t>> TicketRepository::get_statement_stats() const {
+    return statements.get_execution_counts();
 }
 
 Ticket TicketRepository::create_ticket_from_row(const pqxx::row& row) {
@@ -62,11 +131,19 @@ Ticket TicketRepository::create_ticket_from_row(const pqxx::row& row) {
         Ticket ticket;
         
         ticket.id = row["id"].as<int>();
-        ticket.ticket_uid = row["ticket_uid"].as<std::string>();
+        // uuid и статус разбираются из текста поля без промежуточных строк
+        auto ticket_uid = Uuid::parse(row["ticket_uid"].view());
+        auto status = parse_ticket_status(row["status"].view());
+
+        if (!ticket_uid || !status) {
+            throw std::runtime_error("Invalid ticket row: id " + std::to_string(ticket.id));
+        }
+
+        ticket.ticket_uid = *ticket_uid;
         ticket.username = row["username"].as<std::string>();
-        ticket.flight_number = row["flight_number"].as<std::string>();
+        ticket.flight_number = FlightNumber(row["flight_number"].view());
         ticket.price = row["price"].as<int>();
-        ticket.status = row["status"].as<std::string>();
+        ticket.status = *status;
         
         
         return ticket;
@@ -85,18 +162,12 @@ Ticket TicketRepository::create_ticket(const std::string& username,
             throw std::runtime_error("Database not connected");
         }
 
-        std::string ticket_uid = UUIDGenerator::generate_uuid_v4();
+        std::string ticket_uid = UUIDGenerator::generate().str();
         
+        auto connection = pool->acquire();
         pqxx::work txn(*connection);
         
-        std::string sql = R"(
-            INSERT INTO ticket (ticket_uid, username, flight_number, price, status)
-            VALUES ($1, $2, $3, $4, $5)
-            RETURNING id, ticket_uid, username, flight_number, price, status
-        )";
-        
-        auto result = txn.exec(
-            sql, 
+        auto result = statements.exec(txn, "create_ticket",
             pqxx::params{ ticket_uid, username, flight_number, price, status}
         );
         
@@ -106,6 +177,14 @@ Ticket TicketRepository::create_ticket(const std::string& username,
         
         Ticket ticket = create_ticket_from_row(result[0]);
         txn.commit();
+
+        if (replicas) {
+            replicas->record_write(username);
+        }
+
+        if (cache) {
+            cache->on_ticket_created(ticket);
+        }
         
         return ticket;
         
@@ -114,37 +193,125 @@ Ticket TicketRepository::create_ticket(const std::string& username,
     }
 }
 
+// Создание пачки билетов
+std::vector<Ticket> TicketRepository::create_tickets(const std::vector<NewTicket>& tickets) {
+    std::vector<Ticket> created;
+
+    if (tickets.empty()) {
+        return created;
+    }
+
+    try {
+        if (!is_connected()) {
+            throw std::runtime_error("Database not connected");
+        }
+
+        std::vector<std::string> ticket_uids;
+        std::vector<std::string> usernames;
+        std::vector<std::string> flight_numbers;
+        std::vector<int> prices;
+        std::vector<std::string> statuses;
+
+        ticket_uids.reserve(tickets.size());
+        usernames.reserve(tickets.size());
+        flight_numbers.reserve(tickets.size());
+        prices.reserve(tickets.size());
+        statuses.reserve(tickets.size());
+
+        // ticket_uid -> позиция во входе
+        std::unordered_map<Uuid, std::size_t> positions;
+
+        for (const auto& ticket : tickets) {
+            Uuid ticket_uid = UUIDGenerator::generate();
+            positions.emplace(ticket_uid, ticket_uids.size());
+
+            ticket_uids.push_back(ticket_uid.str());
+            usernames.push_back(ticket.username);
+            flight_numbers.push_back(ticket.flight_number);
+            prices.push_back(ticket.price);
+            statuses.push_back(ticket.status);
+        }
+
+        auto connection = pool->acquire();
+        pqxx::work txn(*connection);
+
+        auto result = statements.exec(txn, "create_tickets",
+            pqxx::params{ ticket_uids, usernames, flight_numbers, prices, statuses });
+
+        if (result.size() != tickets.size()) {
+            throw std::runtime_error("Failed to create tickets");
+        }
+
+        created.resize(tickets.size());
+
+        for (const auto& row : result) {
+            Ticket ticket = create_ticket_from_row(row);
+            created[positions.at(ticket.ticket_uid)] = std::move(ticket);
+        }
+
+        txn.commit();
+
+        if (replicas) {
+            for (const auto& ticket : tickets) {
+                replicas->record_write(ticket.username);
+            }
+        }
+
+        if (cache) {
+            for (const auto& ticket : created) {
+                cache->on_ticket_created(ticket);
+            }
+        }
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error creating tickets: " << e.what() << std::endl;
+        throw;
+    }
+
+    return created;
+}
+
 // Получить билет по UUID
-std::optional<Ticket> TicketRepository::get_ticket_by_uid(const std::string& ticket_uid) {
+std::optional<Ticket> TicketRepository::get_ticket_by_uid(const std::string& ticket_uid,
+                                                         const std::string& username) {
     try {
         if (!is_connected()) {
             throw std::runtime_error("Database not connected");
         }
         
-        if (!UUIDGenerator::is_valid_uuid(ticket_uid)) {
+        auto uid = UUIDGenerator::is_valid_uuid(ticket_uid) ? Uuid::parse(ticket_uid) : std::nullopt;
+
+        if (!uid) {
             std::cerr << "Invalid UUID format: " << ticket_uid << std::endl;
             return std::nullopt;
         }
+
+        std::uint64_t cache_version = 0;
+
+        if (cache) {
+            if (auto cached = cache->get_ticket(*uid)) {
+                return cached;
+            }
+            cache_version = cache->ticket_version(*uid);
+        }
         
-        pqxx::work txn(*connection);
-        
-        std::string sql = R"(
-            SELECT id, ticket_uid, username, flight_number, price, status
-            FROM ticket
-            WHERE ticket_uid = $1
-        )";
-        
-        auto result = txn.exec(sql,
-            pqxx::params{ ticket_uid }
-        );
+        auto query = [&](pqxx::connection& connection) {
+            pqxx::read_transaction txn(connection);
+            return statements.exec(txn, "get_ticket_by_uid", pqxx::params{ ticket_uid });
+        };
 
-        txn.commit();
+        // Без username нельзя проверить read-your-writes - читаем с primary
+        auto result = username.empty() ? query(*pool->acquire()) : read(username, query);
 
         if (result.empty()) {
             return std::nullopt;
         }
         
         Ticket ticket = create_ticket_from_row(result[0]);
+
+        if (cache) {
+            cache->fill_ticket(ticket, cache_version);
+        }
         
         return ticket;
         
@@ -155,28 +322,56 @@ std::optional<Ticket> TicketRepository::get_ticket_by_uid(const std::string& tic
 }
 
 // Получить все билеты пользователя
-std::vector<Ticket> TicketRepository::get_tickets_by_username(const std::string& username) {
+std::vector<Ticket> TicketRepository::get_tickets_by_username(const std::string& username,
+                                                              const std::optional<std::string>& status) {
     std::vector<Ticket> tickets;
     
     try {
         if (!is_connected()) {
             throw std::runtime_error("Database not connected");
         }
-        
-        pqxx::work txn(*connection);
-        
-        std::string sql = R"(
-            SELECT id, ticket_uid, username, flight_number, price, status
-            FROM ticket
-            WHERE username = $1
-        )";
-        
-        auto result = txn.exec(sql,
-            pqxx::params{ username });
-        txn.commit();
 
-        for (const auto& row : result) {
-            tickets.push_back(create_ticket_from_row(row));
+        std::uint64_t cache_version = 0;
+        std::optional<std::vector<Ticket>> all_tickets;
+
+        // В кэше - полный список; фильтр по статусу применяется к нему
+        if (cache) {
+            all_tickets = cache->get_user_tickets(username);
+
+            if (!all_tickets) {
+                cache_version = cache->user_version(username);
+            }
+        }
+
+        if (!all_tickets) {
+            auto result = read(username, [&](pqxx::connection& connection) {
+                pqxx::read_transaction txn(connection);
+                return statements.exec(txn, "get_tickets_by_username",
+                    pqxx::params{ username, cache ? std::nullopt : status });
+            });
+
+            all_tickets.emplace();
+            all_tickets->reserve(result.size());
+
+            for (const auto& row : result) {
+                all_tickets->push_back(create_ticket_from_row(row));
+            }
+
+            if (cache) {
+                cache->fill_user_tickets(username, *all_tickets, cache_version);
+            }
+        }
+
+        if (!cache || !status) {
+            return std::move(*all_tickets);
+        }
+
+        auto wanted = parse_ticket_status(*status);
+
+        for (auto& ticket : *all_tickets) {
+            if (ticket.status == wanted) {
+                tickets.push_back(std::move(ticket));
+            }
         }
         
     } catch (const std::exception& e) {
@@ -186,6 +381,109 @@ std::vector<Ticket> TicketRepository::get_tickets_by_username(const std::string&
     return tickets;
 }
 
+std::string TicketRepository::encode_cursor(const std::string& purchased_at, int id) {
+    static const char digits[] = "0123456789abcdef";
+
+    std::string raw = purchased_at + "|" + std::to_string(id);
+    std::string cursor;
+    cursor.reserve(raw.size() * 2);
+
+    for (unsigned char c : raw) {
+        cursor.push_back(digits[c >> 4]);
+        cursor.push_back(digits[c & 0xF]);
+    }
+
+    return cursor;
+}
+
+std::pair<std::string, int> TicketRepository::decode_cursor(const std::string& cursor) {
+    auto hex_value = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    };
+
+    if (cursor.empty() || cursor.size() % 2 != 0) {
+        throw std::invalid_argument("Invalid cursor");
+    }
+
+    std::string raw;
+    raw.reserve(cursor.size() / 2);
+
+    for (std::size_t i = 0; i < cursor.size(); i += 2) {
+        int high = hex_value(cursor[i]);
+        int low = hex_value(cursor[i + 1]);
+
+        if (high < 0 || low < 0) {
+            throw std::invalid_argument("Invalid cursor");
+        }
+        raw.push_back(static_cast<char>(high * 16 + low));
+    }
+
+    auto separator = raw.rfind('|');
+    if (separator == std::string::npos || separator == 0) {
+        throw std::invalid_argument("Invalid cursor");
+    }
+
+    try {
+        std::size_t parsed = 0;
+        int id = std::stoi(raw.substr(separator + 1), &parsed);
+
+        if (parsed != raw.size() - separator - 1) {
+            throw std::invalid_argument("Invalid cursor");
+        }
+        return { raw.substr(0, separator), id };
+    } catch (const std::logic_error&) {
+        throw std::invalid_argument("Invalid cursor");
+    }
+}
+
+// Страница билетов пользователя
+TicketRepository::TicketPage TicketRepository::get_tickets_page(const TicketPageQuery& query) {
+    TicketPage page;
+
+    try {
+        if (!is_connected()) {
+            throw std::runtime_error("Database not connected");
+        }
+
+        std::optional<std::pair<std::string, int>> after;
+        if (!query.cursor.empty()) {
+            after = decode_cursor(query.cursor);
+        }
+
+        auto result = read(query.username, [&](pqxx::connection& connection) {
+            pqxx::read_transaction txn(connection);
+
+            if (after) {
+                return statements.exec(txn, "get_tickets_after_cursor",
+                    pqxx::params{ query.username, query.status, after->first, after->second, query.page_size + 1 });
+            }
+            return statements.exec(txn, "get_tickets_page",
+                pqxx::params{ query.username, query.status, query.page_size + 1,
+                    static_cast<long long>(query.page - 1) * query.page_size });
+        });
+
+        std::size_t count = std::min(result.size(), static_cast<std::size_t>(query.page_size));
+        page.tickets.reserve(count);
+
+        for (std::size_t i = 0; i < count; ++i) {
+            page.tickets.push_back(create_ticket_from_row(result[i]));
+        }
+
+        if (result.size() > count) {
+            const auto& last = result[count - 1];
+            page.next_cursor = encode_cursor(last["purchased_at"].as<std::string>(), last["id"].as<int>());
+        }
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error getting tickets page: " << e.what() << std::endl;
+        throw;
+    }
+
+    return page;
+}
+
 // Обновить статус билета
 bool TicketRepository::update_ticket_status(const std::string& ticket_uid, 
                                           const std::string& new_status) {
@@ -194,19 +492,21 @@ bool TicketRepository::update_ticket_status(const std::string& ticket_uid,
             throw std::runtime_error("Database not connected");
         }
         
+        auto connection = pool->acquire();
         pqxx::work txn(*connection);
         
-        std::string sql = R"(
-            UPDATE ticket
-            SET status = $1
-            WHERE ticket_uid = $2
-            RETURNING id
-        )";
-        
-        auto result = txn.exec(sql,
+        auto result = statements.exec(txn, "update_ticket_status",
             pqxx::params{ new_status, ticket_uid }
         );
         txn.commit();
+
+        if (replicas && !result.empty()) {
+            replicas->record_write(result[0]["username"].as<std::string>());
+        }
+
+        if (cache && !result.empty()) {
+            cache->on_ticket_updated(create_ticket_from_row(result[0]));
+        }
         
         return !result.empty(); 
 
@@ -216,23 +516,151 @@ bool TicketRepository::update_ticket_status(const std::string& ticket_uid,
     }
 }
 
-// Проверить, принадлежит ли билет пользователю
-bool TicketRepository::ticket_belongs_to_user(const std::string& ticket_uid, 
-                                            const std::string& username) {
+// Отменить билет пользователя
+TicketRepository::CancelResult TicketRepository::cancel_ticket(const std::string& ticket_uid,
+                                                               const std::string& username) {
+    CancelResult cancel;
+
     try {
         if (!is_connected()) {
             throw std::runtime_error("Database not connected");
         }
-        
-        auto ticket_opt = get_ticket_by_uid(ticket_uid);
-        if (!ticket_opt) {
-            return false;
+
+        if (!UUIDGenerator::is_valid_uuid(ticket_uid)) {
+            return cancel;
         }
-        
-        return ticket_opt->username == username;
-        
+
+        auto connection = pool->acquire();
+        pqxx::work txn(*connection);
+
+        auto result = statements.exec(txn, "cancel_ticket",
+            pqxx::params{ ticket_uid, username });
+
+        if (!result.empty()) {
+            cancel.status = CancelStatus::Canceled;
+            cancel.ticket = create_ticket_from_row(result[0]);
+        }
+        else {
+            // Билета нет, он чужой или уже отменен - различаем только при отказе
+            auto existing = statements.exec(txn, "get_ticket_by_uid",
+                pqxx::params{ ticket_uid });
+
+            if (!existing.empty() &&
+                existing[0]["username"].view() == username &&
+                existing[0]["status"].view() == "CANCELED") {
+                cancel.status = CancelStatus::AlreadyCanceled;
+            }
+        }
+
+        txn.commit();
+
+        if (replicas && cancel.ticket) {
+            replicas->record_write(username);
+        }
+
+        if (cache && cancel.ticket) {
+            Ticket canceled = *cancel.ticket;
+            canceled.status = TicketStatus::Canceled;
+            cache->on_ticket_updated(canceled);
+        }
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error canceling ticket: " << e.what() << std::endl;
+        throw;
+    }
+
+    return cancel;
+}
+
+// Отмена билетов рейса
+std::vector<Ticket> TicketRepository::cancel_flight_tickets(const std::string& flight_number, int limit) {
+    std::vector<Ticket> canceled;
+
+    try {
+        if (!is_connected()) {
+            throw std::runtime_error("Database not connected");
+        }
+
+        auto connection = pool->acquire();
+        pqxx::work txn(*connection);
+
+        auto result = statements.exec(txn, "cancel_flight_tickets",
+            pqxx::params{ flight_number, limit });
+        txn.commit();
+
+        canceled.reserve(result.size());
+
+        for (const auto& row : result) {
+            canceled.push_back(create_ticket_from_row(row));
+        }
+
+        for (const auto& ticket : canceled) {
+            if (replicas) {
+                replicas->record_write(ticket.username);
+            }
+            if (cache) {
+                cache->on_ticket_updated(ticket);
+            }
+        }
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error canceling flight tickets: " << e.what() << std::endl;
+        throw;
+    }
+
+    return canceled;
+}
+
+// Выгрузка билетов рейса
+std::size_t TicketRepository::export_flight_tickets(const std::string& flight_number,
+                                                    const std::optional<std::string>& status,
+                                                    std::ostream& out) {
+    std::size_t count = 0;
+
+    try {
+        if (!is_connected()) {
+            throw std::runtime_error("Database not connected");
+        }
+
+        // Выгрузка не привязана к пользователю - подходит любая реплика
+        ConnectionPool* source = replicas ? replicas->pool_for_read("") : nullptr;
+
+        auto connection = (source ? source : pool.get())->acquire();
+        pqxx::read_transaction txn(*connection);
+
+        // stream() выполняет COPY и не принимает параметров - значения экранируются
+        std::string query =
+            "SELECT ticket_uid, username, flight_number, price, status, purchased_at "
+            "FROM ticket WHERE flight_number = " + txn.quote(flight_number);
+
+        if (status) {
+            query += " AND status = " + txn.quote(*status);
+        }
+
+        query += " ORDER BY id";
+
+        nlohmann::json line = nlohmann::json::object();
+
+        for (auto [ticket_uid, username, number, price, ticket_status, purchased_at] :
+            txn.stream<std::string_view, std::string_view, std::string_view, int, std::string_view, std::string_view>(query)) {
+
+            line["ticketUid"] = ticket_uid;
+            line["username"] = username;
+            line["flightNumber"] = number;
+            line["price"] = price;
+            line["status"] = ticket_status;
+            line["purchasedAt"] = purchased_at;
+
+            out << line.dump() << '\n';
+            ++count;
+        }
+
+        txn.commit();
+
     } catch (const std::exception& e) {
-        std::cerr << "Error checking ticket ownership: " << e.what() << std::endl;
+        std::cerr << "Error exporting flight tickets: " << e.what() << std::endl;
         throw;
     }
-}
\ No newline at end of file
+
+    return count;
+}
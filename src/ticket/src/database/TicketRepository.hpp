@@ -2,32 +2,127 @@
 #include <memory>
 #include <vector>
 #include <optional>
+#include <cstdint>
+#include <ostream>
+#include <iostream>
 #include <pqxx/pqxx>
+#include "ConnectionPool.hpp"
+#include "ReplicaRouter.hpp"
+#include "StatementRegistry.hpp"
 #include "../models/Ticket.hpp"
+#include "../cache/TicketCache.hpp"
 
 class TicketRepository {
 private:
-    std::unique_ptr<pqxx::connection> connection;
+    StatementRegistry statements;
+    std::unique_ptr<ConnectionPool> pool;
+
+    // Кэш билетов; nullptr - все чтения из БД
+    TicketCache* cache;
+
+    // Реплики для чтения; nullptr - все запросы на primary
+    std::unique_ptr<ReplicaRouter> replicas;
     
 public:
-    TicketRepository(const std::string& connection_string);
+    TicketRepository(const std::string& connection_string, std::size_t pool_size = 8, TicketCache* cache = nullptr,
+                     const ReplicaRouter::Options& replica_options = {});
     ~TicketRepository();
     
     bool connect();
     bool is_connected() const;
+
+    // Количество выполнений каждого prepared statement
+    std::vector<std::pair<std::string, std::uint64_t>> get_statement_stats() const;
     
     Ticket create_ticket(const std::string& username, 
                         const std::string& flight_number, 
                         int price,
                         const std::string status);
     
-    std::optional<Ticket> get_ticket_by_uid(const std::string& ticket_uid);
-    std::vector<Ticket> get_tickets_by_username(const std::string& username);
+    struct NewTicket {
+        std::string username;
+        std::string flight_number;
+        int price;
+        std::string status;
+    };
+
+    // Несколько билетов одним INSERT в одной транзакции; результат в порядке входа
+    std::vector<Ticket> create_tickets(const std::vector<NewTicket>& tickets);
     
-    bool update_ticket_status(const std::string& ticket_uid, const std::string& new_status);
+    // username - кто читает (для read-your-writes); пусто - чтение с primary
+    std::optional<Ticket> get_ticket_by_uid(const std::string& ticket_uid, const std::string& username = "");
+    // Все билеты пользователя, новые первыми; status - необязательный фильтр
+    std::vector<Ticket> get_tickets_by_username(const std::string& username,
+                                               const std::optional<std::string>& status = std::nullopt);
+
+    struct TicketPageQuery {
+        std::string username;
+        std::optional<std::string> status;
+        int page = 1;
+        int page_size = 20;
+        // Непрозрачный курсор из предыдущей страницы; если задан, page не используется
+        std::string cursor;
+    };
+
+    struct TicketPage {
+        std::vector<Ticket> tickets;
+        // Пусто - страниц больше нет
+        std::string next_cursor;
+    };
+
+    // Страница билетов пользователя в порядке (purchased_at DESC, id DESC).
+    // Бросает std::invalid_argument на некорректный курсор.
+    TicketPage get_tickets_page(const TicketPageQuery& query);
     
-    bool ticket_belongs_to_user(const std::string& ticket_uid, const std::string& username);
+    bool update_ticket_status(const std::string& ticket_uid, const std::string& new_status);
+
+    enum class CancelStatus { Canceled, NotFound, AlreadyCanceled };
+
+    struct CancelResult {
+        CancelStatus status = CancelStatus::NotFound;
+        // Билет до отмены (только для Canceled)
+        std::optional<Ticket> ticket;
+    };
+
+    // Отмена оплаченного билета пользователя одним условным UPDATE
+    CancelResult cancel_ticket(const std::string& ticket_uid, const std::string& username);
+
+    // Отмена до limit оплаченных билетов рейса одним UPDATE; возвращает отмененные.
+    // Повторять, пока результат не пуст.
+    std::vector<Ticket> cancel_flight_tickets(const std::string& flight_number, int limit);
+
+    // Билеты рейса построчно (COPY TO) в out как NDJSON; возвращает число строк.
+    // Память не зависит от количества билетов.
+    std::size_t export_flight_tickets(const std::string& flight_number,
+                                      const std::optional<std::string>& status,
+                                      std::ostream& out);
     
 private:
+    void register_statements();
+
     Ticket create_ticket_from_row(const pqxx::row& row);
+
+    // Чтение на реплике (если есть подходящая), иначе на primary.
+    // При обрыве соединения с репликой запрос повторяется на primary.
+    template <typename Fn>
+    auto read(const std::string& username, Fn&& fn) {
+        if (replicas) {
+            if (ConnectionPool* replica_pool = replicas->pool_for_read(username)) {
+                try {
+                    auto connection = replica_pool->acquire();
+                    return fn(*connection);
+                } catch (const pqxx::broken_connection& e) {
+                    std::cerr << "Replica read failed, retrying on primary: " << e.what() << std::endl;
+                    replicas->report_failure(replica_pool);
+                }
+            }
+        }
+
+        auto connection = pool->acquire();
+        return fn(*connection);
+    }
+
+    // Курсор - hex от "purchased_at|id" последней строки страницы
+    static std::string encode_cursor(const std::string& purchased_at, int id);
+    static std::pair<std::string, int> decode_cursor(const std::string& cursor);
 };
\ No newline at end of file
@@ -1,10 +1,42 @@
 #include <iostream>
 #include <string>
+#include <cstdlib>
+#include <memory>
+#include <algorithm>
+#include <sstream>
+#include <fstream>
 #include <crow.h>
 #include "api/TicketController.hpp"
 #include "database/TicketRepository.hpp"
+#include "database/Migrations.hpp"
+#include "database/TicketBatchWriter.hpp"
+#include "cache/TicketCache.hpp"
+#include "report/RevenueReport.hpp"
+#include "api/ExportCleaner.hpp"
+
+int main(int argc, char* argv[]) {
+    // --migrate-only    - применить миграции и завершить работу
+    // --skip-migrations - не применять миграции при старте
+    // --revenue-report <file> - отчет по рейсам в файл и завершить работу
+    // --bonus-usage <file>    - бонусы по билетам для отчета (bonus_service --export-bonus-usage)
+    bool migrate_only = false;
+    bool skip_migrations = false;
+    std::string revenue_report_path;
+    std::string bonus_usage_path;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--migrate-only") {
+            migrate_only = true;
+        } else if (arg == "--skip-migrations") {
+            skip_migrations = true;
+        } else if (arg == "--revenue-report" && i + 1 < argc) {
+            revenue_report_path = argv[++i];
+        } else if (arg == "--bonus-usage" && i + 1 < argc) {
+            bonus_usage_path = argv[++i];
+        }
+    }
 
-int main() {
     
     crow::SimpleApp app;
     
@@ -13,7 +45,81 @@ int main() {
     std::cout << db_connection_string << std::endl;
     
     try {
-        TicketRepository ticket_repository(db_connection_string);
+        if (!skip_migrations) {
+            MigrationRunner migration_runner(db_connection_string, ticket_migrations());
+            int applied = migration_runner.run();
+            std::cout << "Ticket Service: applied migrations: " << applied << std::endl;
+        }
+
+        if (migrate_only) {
+            return 0;
+        }
+
+        if (!revenue_report_path.empty()) {
+            // TICKET_REPORT_DB - источник отчета (например, реплика);
+            // TICKET_REPORT_WORKERS - число потоков
+            const char* report_db_env = std::getenv("TICKET_REPORT_DB");
+            const char* workers_env = std::getenv("TICKET_REPORT_WORKERS");
+
+            RevenueReport::Options report_options;
+            report_options.ticket_connection = report_db_env ? report_db_env : db_connection_string;
+            report_options.bonus_usage_path = bonus_usage_path;
+
+            if (workers_env) {
+                int workers = std::stoi(workers_env);
+                if (workers <= 0) {
+                    std::cerr << "TICKET_REPORT_WORKERS must be positive" << std::endl;
+                    return 1;
+                }
+                report_options.workers = static_cast<std::size_t>(workers);
+            }
+
+            std::ofstream report_file(revenue_report_path);
+            if (!report_file) {
+                std::cerr << "Cannot open report file " << revenue_report_path << std::endl;
+                return 1;
+            }
+
+            RevenueReport report(report_options);
+            auto summary = report.run(report_file);
+
+            std::cout << "Revenue report: " << summary.tickets << " tickets, "
+                      << summary.flights << " flights, "
+                      << summary.bonus_tickets << " tickets with bonus operations in "
+                      << summary.seconds << " s (" << static_cast<long long>(summary.rows_per_second)
+                      << " rows/s)" << std::endl;
+            return 0;
+        }
+
+        // TICKET_CACHE_SIZE - число билетов в кэше (0 - без кэша)
+        const char* cache_env = std::getenv("TICKET_CACHE_SIZE");
+        int cache_size = cache_env ? std::stoi(cache_env) : 10000;
+
+        std::unique_ptr<TicketCache> ticket_cache;
+        if (cache_size > 0) {
+            ticket_cache = std::make_unique<TicketCache>(cache_size, std::max(cache_size / 10, 16));
+        }
+
+        // TICKET_DB_REPLICAS - строки подключения реплик через запятую;
+        // TICKET_REPLICA_MAX_LAG_MS - допустимое отставание реплики
+        ReplicaRouter::Options replica_options;
+
+        if (const char* replicas_env = std::getenv("TICKET_DB_REPLICAS")) {
+            std::stringstream replicas_stream(replicas_env);
+            std::string replica;
+
+            while (std::getline(replicas_stream, replica, ',')) {
+                if (!replica.empty()) {
+                    replica_options.connection_strings.push_back(replica);
+                }
+            }
+        }
+
+        if (const char* lag_env = std::getenv("TICKET_REPLICA_MAX_LAG_MS")) {
+            replica_options.max_lag = std::chrono::milliseconds(std::stoi(lag_env));
+        }
+
+        TicketRepository ticket_repository(db_connection_string, 8, ticket_cache.get(), replica_options);
         
         if (!ticket_repository.connect()) {
             std::cerr << "Ошибка подключения Ticket Service к базе данных: " << std::endl;
@@ -22,7 +128,33 @@ int main() {
         
         std::cout << "Ticket Service: Repository initialized successfully" << std::endl;
         
-        TicketController controller(ticket_repository);
+        // TICKET_BATCH_WRITES=1 - групповая запись билетов:
+        // до TICKET_BATCH_MAX билетов за TICKET_BATCH_WAIT_US микросекунд
+        std::unique_ptr<TicketBatchWriter> batch_writer;
+        const char* batch_mode = std::getenv("TICKET_BATCH_WRITES");
+
+        if (batch_mode && std::string(batch_mode) == "1") {
+            const char* max_env = std::getenv("TICKET_BATCH_MAX");
+            const char* wait_env = std::getenv("TICKET_BATCH_WAIT_US");
+
+            int batch_max = max_env ? std::stoi(max_env) : 64;
+            int batch_wait_us = wait_env ? std::stoi(wait_env) : 2000;
+
+            batch_writer = std::make_unique<TicketBatchWriter>(ticket_repository,
+                batch_max > 0 ? batch_max : 64,
+                std::chrono::microseconds(batch_wait_us >= 0 ? batch_wait_us : 2000));
+            batch_writer->start();
+        }
+        
+        // TICKET_EXPORT_DIR - каталог временных файлов выгрузки билетов
+        const char* export_env = std::getenv("TICKET_EXPORT_DIR");
+        std::string export_dir = export_env ? export_env : "/tmp/ticket-exports";
+
+        // Файлы выгрузок старше 10 минут уже отданы клиенту; проверка раз в минуту
+        ExportCleaner export_cleaner(export_dir, std::chrono::minutes(10), std::chrono::minutes(1));
+        export_cleaner.start();
+
+        TicketController controller(ticket_repository, batch_writer.get(), ticket_cache.get(), export_dir);
         
         controller.router(app);
         
@@ -0,0 +1,50 @@
+#pragma once
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <unordered_map>
+
+// Номер рейса из общего пула строк процесса: у всех билетов одного рейса
+// один экземпляр строки. Строки пула не удаляются - число рейсов ограничено.
+class FlightNumber {
+public:
+    FlightNumber() : value(&empty()) {}
+
+    explicit FlightNumber(std::string_view number) : value(&intern(number)) {}
+
+    std::string_view view() const { return *value; }
+    const std::string& str() const { return *value; }
+
+    bool operator==(const FlightNumber& other) const { return value == other.value; }
+    bool operator!=(const FlightNumber& other) const { return value != other.value; }
+
+private:
+    static const std::string& empty() {
+        static const std::string value;
+        return value;
+    }
+
+    // Ключ - view на строку, которой владеет сам пул: поиск без аллокаций
+    static const std::string& intern(std::string_view number) {
+        static std::shared_mutex mutex;
+        static std::unordered_map<std::string_view, std::unique_ptr<const std::string>> pool;
+
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            auto it = pool.find(number);
+            if (it != pool.end()) {
+                return *it->second;
+            }
+        }
+
+        auto owned = std::make_unique<const std::string>(number);
+        std::string_view key(*owned);
+
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        return *pool.emplace(key, std::move(owned)).first->second;
+    }
+
+    const std::string* value;
+};
@@ -1,34 +1,36 @@
 #pragma once
 #include <string>
-#include <chrono>
 #include <nlohmann/json.hpp>
+#include "Uuid.hpp"
+#include "TicketStatus.hpp"
+#include "FlightNumber.hpp"
 
 class Ticket {
 public:
-    int id;
-    std::string ticket_uid;
+    int id = 0;
+    int price = 0;
+    TicketStatus status = TicketStatus::Paid;
+    Uuid ticket_uid;
+    FlightNumber flight_number;
     std::string username;
-    std::string flight_number;
-    int price;
-    std::string status;
     
     Ticket() = default;
     
     Ticket(const std::string& username, const std::string& flight_number, 
-           int price, const std::string& status)
-        : username(username)
+           int price, TicketStatus status = TicketStatus::Paid)
+        : price(price)
+        , status(status)
         , flight_number(flight_number)
-        , price(price)
-        , status(std::string{"PAID"}) {
+        , username(username) {
     }
 
     // Для API
     nlohmann::json to_api_json() const {
         return {
-            {"ticketUid", ticket_uid},
-            {"flightNumber", flight_number},
+            {"ticketUid", ticket_uid.str()},
+            {"flightNumber", flight_number.str()},
             {"price", price},
-            {"status", status}
+            {"status", to_string(status)}
         };
     }
     
@@ -36,10 +38,10 @@ public:
         Ticket ticket;
         
         ticket.id = j["id"];
-        ticket.flight_number = j["flightNumber"];
+        ticket.flight_number = FlightNumber(j["flightNumber"].get<std::string>());
         ticket.price = j["price"];
-        ticket.status = j["status"];
+        ticket.status = parse_ticket_status(j["status"].get<std::string>()).value_or(TicketStatus::Paid);
         
         return ticket;
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+enum class TicketStatus : std::uint8_t {
+    Paid,
+    Canceled
+};
+
+inline const char* to_string(TicketStatus status) {
+    return status == TicketStatus::Paid ? "PAID" : "CANCELED";
+}
+
+inline std::optional<TicketStatus> parse_ticket_status(std::string_view text) {
+    if (text == "PAID") return TicketStatus::Paid;
+    if (text == "CANCELED") return TicketStatus::Canceled;
+    return std::nullopt;
+}
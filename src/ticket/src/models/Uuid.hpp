@@ -0,0 +1,98 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// UUID в 16 байтах. В текст переводится только на границе API и БД.
+class Uuid {
+public:
+    Uuid() = default;
+
+    static Uuid from_halves(std::uint64_t high, std::uint64_t low) {
+        Uuid uuid;
+        for (int i = 0; i < 8; ++i) {
+            uuid.bytes_[i] = static_cast<std::uint8_t>(high >> (56 - 8 * i));
+            uuid.bytes_[8 + i] = static_cast<std::uint8_t>(low >> (56 - 8 * i));
+        }
+        return uuid;
+    }
+
+    // Формат 8-4-4-4-12, hex-цифры в любом регистре
+    static std::optional<Uuid> parse(std::string_view text) {
+        if (text.size() != 36 || text[8] != '-' || text[13] != '-' || text[18] != '-' || text[23] != '-') {
+            return std::nullopt;
+        }
+
+        Uuid uuid;
+        std::size_t pos = 0;
+
+        for (auto& byte : uuid.bytes_) {
+            if (pos == 8 || pos == 13 || pos == 18 || pos == 23) {
+                ++pos;
+            }
+
+            int high = hex_value(text[pos]);
+            int low = hex_value(text[pos + 1]);
+
+            if (high < 0 || low < 0) {
+                return std::nullopt;
+            }
+
+            byte = static_cast<std::uint8_t>(high << 4 | low);
+            pos += 2;
+        }
+
+        return uuid;
+    }
+
+    // Дописывает текстовую форму в нижнем регистре
+    void append_to(std::string& out) const {
+        static constexpr char digits[] = "0123456789abcdef";
+
+        for (std::size_t i = 0; i < bytes_.size(); ++i) {
+            if (i == 4 || i == 6 || i == 8 || i == 10) {
+                out.push_back('-');
+            }
+            out.push_back(digits[bytes_[i] >> 4]);
+            out.push_back(digits[bytes_[i] & 0xF]);
+        }
+    }
+
+    std::string str() const {
+        std::string out;
+        out.reserve(36);
+        append_to(out);
+        return out;
+    }
+
+    const std::array<std::uint8_t, 16>& bytes() const { return bytes_; }
+
+    bool operator==(const Uuid& other) const { return bytes_ == other.bytes_; }
+    bool operator!=(const Uuid& other) const { return bytes_ != other.bytes_; }
+
+private:
+    static int hex_value(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    std::array<std::uint8_t, 16> bytes_{};
+};
+
+namespace std {
+    template <>
+    struct hash<Uuid> {
+        std::size_t operator()(const Uuid& uuid) const noexcept {
+            std::uint64_t high, low;
+            std::memcpy(&high, uuid.bytes().data(), 8);
+            std::memcpy(&low, uuid.bytes().data() + 8, 8);
+            return std::hash<std::uint64_t>{}(high ^ (low * 0x9E3779B97F4A7C15ULL));
+        }
+    };
+}
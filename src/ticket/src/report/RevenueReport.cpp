@@ -0,0 +1,300 @@
+#include "RevenueReport.hpp"
+#include <algorithm>
+#include <chrono>
+#include <charconv>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <iostream>
+#include <tuple>
+#include <pqxx/pqxx>
+#include <nlohmann/json.hpp>
+
+RevenueReport::RevenueReport(Options options)
+    : options(std::move(options)) {
+
+    if (this->options.workers == 0) {
+        this->options.workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    this->options.chunk_rows = std::max<std::size_t>(this->options.chunk_rows, 1);
+    this->options.queue_chunks = std::max<std::size_t>(this->options.queue_chunks, 1);
+}
+
+RevenueReport::Summary RevenueReport::run(std::ostream& out) {
+    Summary summary;
+    auto started = std::chrono::steady_clock::now();
+
+    if (!options.bonus_usage_path.empty()) {
+        load_bonus_usage();
+        summary.bonus_tickets = bonus_usage.size();
+    }
+
+    partitions.clear();
+    for (std::size_t i = 0; i < options.workers; ++i) {
+        partitions.push_back(std::make_unique<Partition>());
+    }
+
+    for (auto& partition : partitions) {
+        Partition* target = partition.get();
+        target->worker = std::thread([this, target]() { work(*target); });
+    }
+
+    try {
+        summary.tickets = stream_tickets();
+    }
+    catch (...) {
+        close_all();
+        for (auto& partition : partitions) {
+            partition->worker.join();
+        }
+        throw;
+    }
+
+    close_all();
+    for (auto& partition : partitions) {
+        partition->worker.join();
+    }
+
+    for (auto& partition : partitions) {
+        if (partition->error) {
+            std::rethrow_exception(partition->error);
+        }
+        summary.flights += partition->flights.size();
+    }
+
+    write(out);
+
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    summary.rows_per_second = summary.seconds > 0 ? summary.tickets / summary.seconds : 0;
+
+    return summary;
+}
+
+void RevenueReport::load_bonus_usage() {
+    std::ifstream in(options.bonus_usage_path);
+    if (!in) {
+        throw std::runtime_error("Cannot open bonus usage file " + options.bonus_usage_path);
+    }
+
+    std::string line;
+    std::size_t line_number = 0;
+
+    while (std::getline(in, line)) {
+        ++line_number;
+
+        // Заголовок и пустые строки
+        if (line.empty() || line_number == 1) {
+            continue;
+        }
+
+        auto comma = line.find(',');
+        std::optional<Uuid> uuid;
+        std::int64_t balance_diff = 0;
+        bool valid = false;
+
+        if (comma != std::string::npos) {
+            uuid = Uuid::parse(std::string_view(line).substr(0, comma));
+
+            const char* begin = line.data() + comma + 1;
+            const char* end = line.data() + line.size();
+            valid = uuid && std::from_chars(begin, end, balance_diff).ptr == end;
+        }
+
+        if (!valid) {
+            throw std::runtime_error("Invalid bonus usage line " + std::to_string(line_number)
+                + " in " + options.bonus_usage_path);
+        }
+
+        bonus_usage[*uuid] += balance_diff;
+    }
+}
+
+std::size_t RevenueReport::stream_tickets() {
+    std::size_t rows = 0;
+    bool with_bonus = !bonus_usage.empty();
+
+    std::vector<Chunk> pending(partitions.size());
+
+    try {
+        pqxx::connection connection(options.ticket_connection);
+        pqxx::read_transaction txn(connection);
+
+        std::string query = "SELECT flight_number, price, status, ticket_uid::text FROM ticket";
+
+        for (auto [flight_number, price, status, ticket_uid] :
+            txn.stream<std::string_view, std::int32_t, std::string_view, std::string_view>(query)) {
+
+            std::size_t target = std::hash<std::string_view>{}(flight_number) % partitions.size();
+            Chunk& chunk = pending[target];
+
+            chunk.flight_numbers.append(flight_number);
+            chunk.flight_ends.push_back(static_cast<std::uint32_t>(chunk.flight_numbers.size()));
+            chunk.prices.push_back(price);
+            chunk.canceled.push_back(status == "CANCELED" ? 1 : 0);
+
+            if (with_bonus) {
+                chunk.ticket_uids.push_back(Uuid::parse(ticket_uid).value_or(Uuid()));
+            }
+
+            if (chunk.size() >= options.chunk_rows) {
+                push(*partitions[target], std::move(chunk));
+                chunk = Chunk();
+            }
+
+            ++rows;
+        }
+
+        txn.commit();
+
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error streaming tickets: " << e.what() << std::endl;
+        throw;
+    }
+
+    for (std::size_t i = 0; i < pending.size(); ++i) {
+        if (pending[i].size() > 0) {
+            push(*partitions[i], std::move(pending[i]));
+        }
+    }
+
+    return rows;
+}
+
+void RevenueReport::push(Partition& partition, Chunk&& chunk) {
+    std::unique_lock<std::mutex> lock(partition.mutex);
+
+    // Чтение COPY ждет отстающий поток, а не копит пачки в памяти
+    partition.cv.wait(lock, [&]() {
+        return partition.queue.size() < options.queue_chunks || partition.error;
+    });
+
+    if (partition.error) {
+        std::rethrow_exception(partition.error);
+    }
+
+    partition.queue.push_back(std::move(chunk));
+    lock.unlock();
+    partition.cv.notify_all();
+}
+
+void RevenueReport::close_all() {
+    for (auto& partition : partitions) {
+        {
+            std::lock_guard<std::mutex> lock(partition->mutex);
+            partition->closed = true;
+        }
+        partition->cv.notify_all();
+    }
+}
+
+void RevenueReport::work(Partition& partition) {
+    std::unique_lock<std::mutex> lock(partition.mutex);
+
+    while (true) {
+        partition.cv.wait(lock, [&]() { return partition.closed || !partition.queue.empty(); });
+
+        if (partition.queue.empty()) {
+            return;
+        }
+
+        Chunk chunk = std::move(partition.queue.front());
+        partition.queue.pop_front();
+
+        lock.unlock();
+        partition.cv.notify_all();
+
+        try {
+            reduce(partition, chunk);
+        }
+        catch (...) {
+            lock.lock();
+            partition.error = std::current_exception();
+            partition.queue.clear();
+            lock.unlock();
+            partition.cv.notify_all();
+            return;
+        }
+
+        lock.lock();
+    }
+}
+
+void RevenueReport::reduce(Partition& partition, const Chunk& chunk) const {
+    bool with_bonus = !chunk.ticket_uids.empty();
+    std::uint32_t begin = 0;
+
+    for (std::size_t i = 0; i < chunk.size(); ++i) {
+        std::string_view flight_number(chunk.flight_numbers.data() + begin, chunk.flight_ends[i] - begin);
+        begin = chunk.flight_ends[i];
+
+        auto it = partition.index.find(flight_number);
+
+        if (it == partition.index.end()) {
+            // deque не перемещает строки - ключи индекса остаются валидными
+            partition.flights.emplace_back(flight_number);
+            it = partition.index.emplace(partition.flights.back(),
+                static_cast<std::uint32_t>(partition.flights.size() - 1)).first;
+
+            partition.sold.push_back(0);
+            partition.canceled.push_back(0);
+            partition.revenue.push_back(0);
+            partition.refunded.push_back(0);
+            partition.bonus_spent.push_back(0);
+            partition.bonus_accrued.push_back(0);
+        }
+
+        std::uint32_t slot = it->second;
+
+        if (chunk.canceled[i]) {
+            partition.canceled[slot] += 1;
+            partition.refunded[slot] += chunk.prices[i];
+        }
+        else {
+            partition.sold[slot] += 1;
+            partition.revenue[slot] += chunk.prices[i];
+        }
+
+        if (with_bonus) {
+            auto usage = bonus_usage.find(chunk.ticket_uids[i]);
+
+            if (usage != bonus_usage.end()) {
+                if (usage->second < 0) {
+                    partition.bonus_spent[slot] -= usage->second;
+                }
+                else {
+                    partition.bonus_accrued[slot] += usage->second;
+                }
+            }
+        }
+    }
+}
+
+void RevenueReport::write(std::ostream& out) const {
+    // Рейсы всех потоков в порядке номера
+    std::vector<std::pair<const Partition*, std::uint32_t>> order;
+
+    for (const auto& partition : partitions) {
+        for (std::uint32_t slot = 0; slot < partition->flights.size(); ++slot) {
+            order.emplace_back(partition.get(), slot);
+        }
+    }
+
+    std::sort(order.begin(), order.end(), [](const auto& a, const auto& b) {
+        return a.first->flights[a.second] < b.first->flights[b.second];
+    });
+
+    nlohmann::json line = nlohmann::json::object();
+
+    for (const auto& [partition, slot] : order) {
+        line["flightNumber"] = partition->flights[slot];
+        line["sold"] = partition->sold[slot];
+        line["canceled"] = partition->canceled[slot];
+        line["revenue"] = partition->revenue[slot];
+        line["refunded"] = partition->refunded[slot];
+        line["bonusSpent"] = partition->bonus_spent[slot];
+        line["bonusAccrued"] = partition->bonus_accrued[slot];
+
+        out << line.dump() << '\n';
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "../models/Uuid.hpp"
+
+// Отчет по рейсам: проданные и отмененные билеты, выручка, возвраты
+// и бонусы, списанные и начисленные за билеты рейса.
+// Работает на отдельном соединении (можно указать реплику) и не использует
+// пул сервиса. Таблица ticket читается одним COPY; строки раскладываются по
+// рабочим потокам по номеру рейса, поэтому итоги рейса считает один поток
+// и слияние не нужно. Бонусы - чистая сумма операций по билету из файла,
+// который выгружает Bonus Service (bonus_service --export-bonus-usage):
+// база бонусов остается за своим сервисом. Возврат билета обнуляет сумму.
+class RevenueReport {
+public:
+    struct Options {
+        std::string ticket_connection;
+        // CSV "ticketUid,balanceDiff" от Bonus Service; пусто - отчет без бонусов
+        std::string bonus_usage_path;
+        // 0 - по числу ядер
+        std::size_t workers = 0;
+        std::size_t chunk_rows = 16384;
+        // Пачек в очереди потока; ограничивает память, если потоки не успевают
+        std::size_t queue_chunks = 4;
+    };
+
+    struct Summary {
+        std::size_t tickets = 0;
+        std::size_t flights = 0;
+        std::size_t bonus_tickets = 0;
+        double seconds = 0;
+        double rows_per_second = 0;
+    };
+
+    explicit RevenueReport(Options options);
+
+    // Пишет строку JSON на рейс (по номеру рейса) в out
+    Summary run(std::ostream& out);
+
+private:
+    // Строки пачки по столбцам
+    struct Chunk {
+        std::string flight_numbers;
+        std::vector<std::uint32_t> flight_ends;
+        std::vector<std::int32_t> prices;
+        std::vector<std::uint8_t> canceled;
+        // Только если отчет с бонусами
+        std::vector<Uuid> ticket_uids;
+
+        std::size_t size() const { return prices.size(); }
+    };
+
+    // Очередь пачек и итоги рейсов одного потока, тоже по столбцам
+    struct Partition {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<Chunk> queue;
+        bool closed = false;
+
+        std::deque<std::string> flights;
+        std::unordered_map<std::string_view, std::uint32_t> index;
+        std::vector<std::int64_t> sold;
+        std::vector<std::int64_t> canceled;
+        std::vector<std::int64_t> revenue;
+        std::vector<std::int64_t> refunded;
+        std::vector<std::int64_t> bonus_spent;
+        std::vector<std::int64_t> bonus_accrued;
+
+        std::thread worker;
+        std::exception_ptr error;
+    };
+
+    void load_bonus_usage();
+    std::size_t stream_tickets();
+
+    void push(Partition& partition, Chunk&& chunk);
+    void close_all();
+    void work(Partition& partition);
+    void reduce(Partition& partition, const Chunk& chunk) const;
+
+    void write(std::ostream& out) const;
+
+    Options options;
+
+    // Чистая сумма бонусных операций по билету; нулевые не хранятся.
+    // Заполняется до запуска потоков, дальше только читается.
+    std::unordered_map<Uuid, std::int64_t> bonus_usage;
+    std::vector<std::unique_ptr<Partition>> partitions;
+};
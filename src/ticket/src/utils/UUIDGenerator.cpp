@@ -1,6 +1,78 @@
 #include "UUIDGenerator.hpp"
+#include <array>
+#include <cstdint>
+#include <random>
 
-std::random_device UUIDGenerator::rd;
-std::mt19937 UUIDGenerator::gen(rd());
-std::uniform_int_distribution<> UUIDGenerator::dis(0, 15);
-std::uniform_int_distribution<> UUIDGenerator::dis2(0, 3);
\ No newline at end of file
+namespace {
+    // Классы символов для is_valid_uuid
+    constexpr std::uint8_t hex_digit = 1;
+    constexpr std::uint8_t dash = 2;
+    constexpr std::uint8_t version_4 = 4;
+    constexpr std::uint8_t variant = 8;
+
+    constexpr std::array<std::uint8_t, 256> make_char_classes() {
+        std::array<std::uint8_t, 256> classes{};
+        for (int c = '0'; c <= '9'; ++c) classes[c] |= hex_digit;
+        for (int c = 'a'; c <= 'f'; ++c) classes[c] |= hex_digit;
+        for (int c = 'A'; c <= 'F'; ++c) classes[c] |= hex_digit;
+        classes['-'] |= dash;
+        classes['4'] |= version_4;
+        for (char c : { '8', '9', 'a', 'b', 'A', 'B' }) classes[static_cast<unsigned char>(c)] |= variant;
+        return classes;
+    }
+
+    constexpr auto char_classes = make_char_classes();
+
+    // Какой класс обязателен в каждой позиции
+    constexpr std::array<std::uint8_t, 36> make_expected_classes() {
+        std::array<std::uint8_t, 36> expected{};
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            expected[i] = hex_digit;
+        }
+        expected[8] = expected[13] = expected[18] = expected[23] = dash;
+        expected[14] = version_4;
+        expected[19] = variant;
+        return expected;
+    }
+
+    constexpr auto expected_classes = make_expected_classes();
+
+    std::mt19937_64& thread_generator() {
+        thread_local std::mt19937_64 generator([]() {
+            std::random_device rd;
+            std::seed_seq seed{ rd(), rd(), rd(), rd(), rd(), rd(), rd(), rd() };
+            return std::mt19937_64(seed);
+        }());
+        return generator;
+    }
+}
+
+Uuid UUIDGenerator::generate() {
+    auto& generator = thread_generator();
+
+    std::uint64_t high = generator();
+    std::uint64_t low = generator();
+
+    // Версия 4 и вариант RFC 4122
+    high = (high & 0xFFFFFFFFFFFF0FFFULL) | 0x0000000000004000ULL;
+    low = (low & 0x3FFFFFFFFFFFFFFFULL) | 0x8000000000000000ULL;
+
+    return Uuid::from_halves(high, low);
+}
+
+std::string UUIDGenerator::generate_uuid_v4() {
+    return generate().str();
+}
+
+bool UUIDGenerator::is_valid_uuid(const std::string& uuid) {
+    if (uuid.size() != expected_classes.size()) {
+        return false;
+    }
+
+    unsigned valid = 1;
+    for (std::size_t i = 0; i < expected_classes.size(); ++i) {
+        valid &= (char_classes[static_cast<unsigned char>(uuid[i])] & expected_classes[i]) != 0;
+    }
+
+    return valid != 0;
+}